@@ -0,0 +1,343 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "batchflashdialog.h"
+#include "bootloaderwatcher.h"
+#include <QDialogButtonBox>
+#include <QGridLayout>
+#include <QLabel>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QThread>
+#include <QTimer>
+#include <QVBoxLayout>
+#include <QtDebug>
+
+BatchFlashDialog::BatchFlashDialog(const QList<batchGun_s> &guns, const Uf2Image images[4], QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Flash All Players");
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    QGridLayout *grid = new QGridLayout();
+    layout->addLayout(grid);
+
+    for(const batchGun_s &gun : guns) {
+        batchRow_s row;
+        row.gun = gun;
+        row.image = images[gun.player];
+        QString location = gun.port.systemLocation();
+        location.remove("\\\\.\\");
+        grid->addWidget(new QLabel(QString("Player %1 (%2)").arg(gun.player + 1).arg(location)), rows.size(), 0);
+        row.progress = new QProgressBar();
+        row.progress->setRange(0, qMax(int(row.image.Data().size()), 1));
+        row.progress->setValue(0);
+        grid->addWidget(row.progress, rows.size(), 1);
+        row.status = new QLabel("Waiting");
+        row.status->setMinimumWidth(240);
+        grid->addWidget(row.status, rows.size(), 2);
+        rows.append(row);
+    }
+
+    summary = new QLabel();
+    layout->addWidget(summary);
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close);
+    closeBtn = buttons->button(QDialogButtonBox::Close);
+    connect(buttons, &QDialogButtonBox::rejected, this, &BatchFlashDialog::reject);
+    layout->addWidget(buttons);
+
+    watcher = new BootloaderWatcher(this);
+    connect(watcher, &BootloaderWatcher::PortGone, this, &BatchFlashDialog::PortGone);
+    connect(watcher, &BootloaderWatcher::ResetFailed, this, &BatchFlashDialog::ResetFailed);
+    connect(watcher, &BootloaderWatcher::Found, this, &BatchFlashDialog::DriveFound);
+    connect(watcher, &BootloaderWatcher::TimedOut, this, &BatchFlashDialog::DriveTimedOut);
+    verifyPoll = new QTimer(this);
+    verifyPoll->setInterval(BATCH_VERIFY_POLL_MS);
+    connect(verifyPoll, &QTimer::timeout, this, &BatchFlashDialog::Verify);
+    lateReset = new QTimer(this);
+    lateReset->setInterval(BOOTLOADER_POLL_MS);
+    connect(lateReset, &QTimer::timeout, this, &BatchFlashDialog::LateResetCheck);
+}
+
+
+BatchFlashDialog::~BatchFlashDialog()
+{
+    // Only reachable mid-write if the app itself is going down; stop after the current chunk.
+    for(QThread *thread : threads) {
+        thread->quit();
+        thread->wait();
+    }
+}
+
+
+void BatchFlashDialog::Start()
+{
+    total.start();
+    closeBtn->setEnabled(false);
+    for(int i = 0; i < rows.size(); i++) {
+        if(rows[i].image.Data().isEmpty()) {
+            Fail(i, "No image for this player");
+        }
+    }
+    ResetNext();
+}
+
+
+bool BatchFlashDialog::IsRunning() const
+{
+    for(const batchRow_s &row : rows) {
+        if(row.state != batchDone && row.state != batchFailed) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void BatchFlashDialog::reject()
+{
+    if(!IsRunning()) {
+        QDialog::reject();
+    }
+}
+
+
+// Resets the next gun still waiting; only one is ever in flight, so the next drive to show up is its.
+void BatchFlashDialog::ResetNext()
+{
+    resetting = -1;
+    for(int i = 0; i < rows.size(); i++) {
+        if(rows[i].state != batchWaiting) {
+            continue;
+        }
+        rows[i].stageTimer.start();
+        if(!watcher->Reset(rows[i].gun.port)) {
+            Fail(i, "Couldn't open its serial port");
+            continue;
+        }
+        resetting = i;
+        rows[i].state = batchResetting;
+        rows[i].status->setText("Resetting...");
+        return;
+    }
+    FinishIfDone();
+}
+
+
+void BatchFlashDialog::PortGone(qint64 elapsedMs)
+{
+    if(resetting >= 0) {
+        rows[resetting].status->setText(QString("Reset after %1 ms, waiting for drive...").arg(elapsedMs));
+    }
+}
+
+
+void BatchFlashDialog::ResetFailed()
+{
+    if(resetting < 0) {
+        ResetNext();
+        return;
+    }
+    // It can still reboot late, and its drive would then pass for the next gun's; nothing else resets until that's settled.
+    rows[resetting].status->setText("Didn't reset yet, giving it a moment...");
+    watcher->Start();
+    settle.start();
+    lateReset->start();
+}
+
+
+void BatchFlashDialog::LateResetCheck()
+{
+    if(resetting < 0) {
+        lateReset->stop();
+        return;
+    }
+    batchRow_s &row = rows[resetting];
+    bool present = false;
+    for(const QSerialPortInfo &port : QSerialPortInfo::availablePorts()) {
+        present |= port.systemLocation() == row.gun.port.systemLocation();
+    }
+    if(!present) {
+        // It took the reset after all; the watcher carries on waiting for its drive.
+        lateReset->stop();
+        qDebug() << "Batch flash: Player" << row.gun.player + 1 << "reset late," << row.stageTimer.elapsed() << "ms after the touch";
+        row.status->setText(QString("Reset after %1 ms, waiting for drive...").arg(row.stageTimer.elapsed()));
+        return;
+    }
+    if(settle.elapsed() >= BATCH_RESET_SETTLE_MS) {
+        lateReset->stop();
+        watcher->Stop();
+        Fail(resetting, "Didn't reset; hold BOOTSEL while plugging it in");
+        ResetNext();
+    }
+}
+
+
+void BatchFlashDialog::DriveFound(const QString &mountPath, qint64)
+{
+    lateReset->stop();
+    if(resetting < 0) {
+        return;
+    }
+    batchRow_s &row = rows[resetting];
+    row.mountPath = mountPath;
+    // From the touch itself, which a late reset's watcher didn't start at
+    row.resetMs = row.stageTimer.elapsed();
+    Flash(resetting);
+    ResetNext();
+}
+
+
+void BatchFlashDialog::DriveTimedOut(qint64 elapsedMs)
+{
+    lateReset->stop();
+    if(resetting >= 0) {
+        Fail(resetting, QString("No bootloader drive after %1 s").arg(elapsedMs / 1000));
+    }
+    ResetNext();
+}
+
+
+// Writes the row's image from a thread of its own, so one slow drive doesn't hold up the others.
+void BatchFlashDialog::Flash(int row)
+{
+    batchRow_s &r = rows[row];
+    r.state = batchFlashing;
+    r.status->setText(QString("Flashing to %1...").arg(r.mountPath));
+    r.stageTimer.start();
+
+    QThread *thread = new QThread(this);
+    Uf2Flasher *flasher = new Uf2Flasher();
+    flasher->moveToThread(thread);
+    connect(thread, &QThread::finished, flasher, &QObject::deleteLater);
+    connect(flasher, &Uf2Flasher::Progress, this, [this, row](qint64 written, qint64 total) {
+        rows[row].progress->setValue(written);
+        rows[row].progress->setFormat(QString("%1 / %2 KB").arg(written / 1024).arg(total / 1024));
+    });
+    connect(flasher, &Uf2Flasher::Verifying, this, [this, row]() {
+        rows[row].status->setText("Reading the flash back...");
+    });
+    connect(flasher, &Uf2Flasher::Finished, this, [this, row, thread, flasher](bool ok, qint64 elapsedMs) {
+        // The flasher's idle once it has reported, so its results are safe to read from here.
+        const QString error = flasher->Error();
+        rows[row].verification = flasher->Verification();
+        thread->quit();
+        thread->wait();
+        threads.removeOne(thread);
+        thread->deleteLater();
+        Flashed(row, ok, elapsedMs, error);
+    });
+    threads.append(thread);
+    thread->start();
+
+    const Uf2Image image = r.image;
+    const QString mountPath = r.mountPath;
+    const QString fileName = QString("Player%1.uf2").arg(r.gun.player + 1);
+    QMetaObject::invokeMethod(flasher, [flasher, image, mountPath, fileName]() {
+        if(!flasher->Start(image, mountPath, fileName)) {
+            emit flasher->Finished(false, 0);
+        }
+    });
+}
+
+
+void BatchFlashDialog::Flashed(int row, bool ok, qint64 elapsedMs, const QString &error)
+{
+    if(!ok) {
+        Fail(row, error);
+        return;
+    }
+    batchRow_s &r = rows[row];
+    r.flashMs = elapsedMs;
+    r.state = batchVerifying;
+    r.status->setText(QString("%1 in %2 ms, waiting for it to come back...")
+                      .arg(r.verification == uf2VerifyPassed ? "Written and read back OK" : "Written (unverified)").arg(elapsedMs));
+    r.stageTimer.start();
+    verifyPoll->start();
+}
+
+
+// A gun's flash only counts once it re-enumerates as its player; each port vouches for one gun only.
+void BatchFlashDialog::Verify()
+{
+    QList<QSerialPortInfo> ports = QSerialPortInfo::availablePorts();
+    // Ports already claimed by guns verified earlier
+    for(const batchRow_s &row : rows) {
+        if(row.state != batchDone) {
+            continue;
+        }
+        for(int p = 0; p < ports.size(); p++) {
+            if(ports[p].systemLocation() == row.gun.port.systemLocation()) {
+                ports.removeAt(p);
+                break;
+            }
+        }
+    }
+
+    bool waiting = false;
+    for(int i = 0; i < rows.size(); i++) {
+        batchRow_s &row = rows[i];
+        if(row.state != batchVerifying) {
+            continue;
+        }
+        bool found = false;
+        for(int p = 0; p < ports.size(); p++) {
+            if(QPair<int, int>(ports[p].vendorIdentifier(), ports[p].productIdentifier()) == row.gun.usbId) {
+                row.gun.port = ports.takeAt(p);
+                found = true;
+                break;
+            }
+        }
+        if(found) {
+            row.state = batchDone;
+            row.status->setText(QString("Passed%1: reset %2 ms, write %3 ms, back after %4 ms")
+                                .arg(row.verification == uf2VerifyPassed ? ", read back OK" : ", unverified")
+                                .arg(row.resetMs).arg(row.flashMs).arg(row.stageTimer.elapsed()));
+            qDebug() << "Batch flash: Player" << row.gun.player + 1 << "back at" << row.gun.port.systemLocation();
+        } else if(row.stageTimer.elapsed() >= BATCH_VERIFY_MS) {
+            Fail(i, QString("Written, but it didn't come back as Player %1").arg(row.gun.player + 1));
+        } else {
+            waiting = true;
+        }
+    }
+    if(!waiting) {
+        verifyPoll->stop();
+    }
+    FinishIfDone();
+}
+
+
+void BatchFlashDialog::Fail(int row, const QString &why)
+{
+    rows[row].state = batchFailed;
+    rows[row].status->setText("FAILED: " + why);
+    qDebug() << "Batch flash: Player" << rows[row].gun.player + 1 << "failed:" << why;
+    FinishIfDone();
+}
+
+
+void BatchFlashDialog::FinishIfDone()
+{
+    if(IsRunning()) {
+        return;
+    }
+    int done = 0;
+    for(const batchRow_s &row : rows) {
+        done += (row.state == batchDone);
+    }
+    summary->setText(QString("%1 of %2 guns flashed in %3 s.").arg(done).arg(rows.size()).arg(total.elapsed() / 1000.0, 0, 'f', 1));
+    closeBtn->setEnabled(true);
+}
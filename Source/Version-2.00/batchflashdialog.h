@@ -0,0 +1,123 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BATCHFLASHDIALOG_H
+#define BATCHFLASHDIALOG_H
+
+#include "uf2flasher.h"
+#include <QDialog>
+#include <QElapsedTimer>
+#include <QList>
+#include <QPair>
+#include <QSerialPortInfo>
+
+class BootloaderWatcher;
+class QLabel;
+class QProgressBar;
+class QPushButton;
+class QThread;
+class QTimer;
+
+// How long a flashed gun gets to come back under its player's VID/PID before it counts as failed
+#define BATCH_VERIFY_MS 15000
+#define BATCH_VERIFY_POLL_MS 250
+// How long a gun that didn't take its reset is watched for a late one before the next gun resets
+#define BATCH_RESET_SETTLE_MS 5000
+
+// Flashes every connected gun in one go, each with the image for the player slot it's already in.
+// Resets go out one gun at a time, so each bootloader drive that appears can only belong to the
+// gun that was just reset; its image starts writing right away (on its own thread) while the next
+// gun resets, so the slow part - the writes - all overlap. A gun that misses its reset is watched
+// until it either goes late or stays put for a while, so its drive can't be taken for the next gun's.
+class BatchFlashDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    typedef struct batchGun_t {
+        QSerialPortInfo port;
+        // Player slot, 0-3
+        uint8_t player;
+        // VID/PID the gun should come back as
+        QPair<int, int> usbId;
+    } batchGun_s;
+
+    // images are indexed by player; guns whose image is empty are skipped.
+    BatchFlashDialog(const QList<batchGun_s> &guns, const Uf2Image images[4], QWidget *parent = nullptr);
+    ~BatchFlashDialog();
+
+    void Start();
+
+    bool IsRunning() const;
+
+protected:
+    void reject() override;
+
+private slots:
+    void ResetNext();
+    void PortGone(qint64 elapsedMs);
+    void ResetFailed();
+    void LateResetCheck();
+    void DriveFound(const QString &mountPath, qint64 elapsedMs);
+    void DriveTimedOut(qint64 elapsedMs);
+    void Verify();
+
+private:
+    enum batchStates_e {
+        batchWaiting = 0,
+        batchResetting,
+        batchFlashing,
+        batchVerifying,
+        batchDone,
+        batchFailed
+    };
+
+    typedef struct batchRow_t {
+        batchGun_s gun;
+        Uf2Image image;
+        uint8_t state = batchWaiting;
+        QString mountPath;
+        // Where each stage's time went, for the summary
+        qint64 resetMs = 0;
+        qint64 flashMs = 0;
+        uf2Verify_e verification = uf2VerifyPassed;
+        QElapsedTimer stageTimer;
+        QProgressBar *progress;
+        QLabel *status;
+    } batchRow_s;
+
+    void Flash(int row);
+    void Flashed(int row, bool ok, qint64 elapsedMs, const QString &error);
+    void Fail(int row, const QString &why);
+    void FinishIfDone();
+
+    QList<batchRow_s> rows;
+    // Row being reset right now, -1 if none
+    int resetting = -1;
+    BootloaderWatcher *watcher;
+    // Polls a gun that missed its reset, for how long set by settle
+    QTimer *lateReset;
+    QElapsedTimer settle;
+    QTimer *verifyPoll;
+    QElapsedTimer total;
+    QLabel *summary;
+    QPushButton *closeBtn;
+    // Flasher threads still running, so closing waits for them
+    QList<QThread*> threads;
+};
+
+#endif // BATCHFLASHDIALOG_H
@@ -0,0 +1,345 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "boardregistry.h"
+#include "pinmap.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtDebug>
+#include <algorithm>
+
+const boardLayout_t rpipicoLayout[] = {
+    {btnGunA, pinDigital},     {btnGunB, pinDigital},
+    {btnGunC, pinDigital},     {btnStart, pinDigital},
+    {btnSelect, pinDigital},   {btnHome, pinDigital},
+    {btnGunUp, pinDigital},    {btnGunDown, pinDigital},
+    {btnGunLeft, pinDigital},  {btnGunRight, pinDigital},
+    {ledR, pinDigital},        {ledG, pinDigital},
+    {ledB, pinDigital},        {btnPump, pinDigital},
+    {btnPedal, pinDigital},    {btnTrigger, pinDigital},
+    {solenoidPin, pinDigital}, {rumblePin, pinDigital},
+    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
+    {btnReserved, pinNothing}, {btnReserved, pinNothing}, // SCL/SDA
+    {btnUnmapped, pinDigital}, {btnReserved, pinNothing}, // 23, 24, 25
+    {btnReserved, pinNothing}, {btnReserved, pinNothing}, // are unused/unexposed
+    {btnUnmapped, pinAnalog},  {btnUnmapped, pinAnalog},  // ADC pins
+    {btnUnmapped, pinAnalog},  {-2, pinNothing}           // ADC, padding
+};
+
+const boardLayout_t adafruitItsyRP2040Layout[] = {
+    {btnGunUp, pinDigital},    {btnGunDown, pinDigital},
+    {btnReserved, pinNothing}, {btnReserved, pinNothing},
+    {btnGunLeft, pinDigital},  {btnGunRight, pinDigital},
+    {btnTrigger, pinDigital},  {btnGunA, pinDigital},
+    {btnGunB, pinDigital},     {btnGunC, pinDigital},
+    {btnStart, pinDigital},    {btnSelect, pinDigital},
+    {btnPedal, pinDigital},    {btnReserved, pinNothing},
+    {btnReserved, pinNothing}, {btnReserved, pinNothing},
+    {btnReserved, pinNothing}, {btnReserved, pinNothing},
+    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
+    {btnUnmapped, pinDigital}, {btnReserved, pinNothing},
+    {btnReserved, pinNothing}, {btnReserved, pinNothing},
+    {rumblePin, pinDigital},   {solenoidPin, pinDigital},
+    {btnUnmapped, pinAnalog},  {btnUnmapped, pinAnalog},
+    {btnUnmapped, pinAnalog},  {btnUnmapped, pinAnalog}
+};
+
+const boardLayout_t adafruitKB2040Layout[] = {
+    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
+    {btnReserved, pinNothing}, {btnReserved, pinNothing},
+    {btnGunB, pinDigital},     {rumblePin, pinDigital},
+    {btnGunC, pinDigital},     {solenoidPin, pinDigital},
+    {btnSelect, pinDigital},   {btnStart, pinDigital},
+    {btnGunRight, pinDigital},
+
+    {btnReserved, pinNothing}, {btnReserved, pinNothing},
+    {btnReserved, pinNothing}, {btnReserved, pinNothing},
+    {btnReserved, pinNothing}, {btnReserved, pinNothing},
+    {btnReserved, pinNothing},
+
+    {btnGunUp, pinDigital},    {btnGunLeft, pinDigital},
+    {btnGunDown, pinDigital},
+
+    {btnReserved, pinNothing}, {btnReserved, pinNothing},
+    {btnReserved, pinNothing}, {btnReserved, pinNothing},
+    {btnReserved, pinNothing},
+
+    {tempPin, pinAnalog},      {btnHome, pinAnalog},
+    {btnTrigger, pinAnalog},   {btnGunA, pinAnalog}
+};
+
+const boardLayout_t arduinoNanoRP2040Layout[] = {
+    {btnTrigger, pinDigital},  {btnPedal, pinDigital},
+    {btnReserved, pinNothing}, {btnReserved, pinNothing},
+    {btnGunA, pinDigital},     {btnGunC, pinDigital},
+    {btnUnmapped, pinDigital}, {btnGunB, pinDigital},
+    {btnReserved, pinNothing}, {btnReserved, pinNothing},
+    {btnReserved, pinNothing}, {btnReserved, pinNothing},
+    {btnReserved, pinNothing}, {btnReserved, pinNothing},
+    {btnReserved, pinNothing}, {btnUnmapped, pinDigital},
+    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
+    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
+    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
+    {btnReserved, pinNothing}, {btnReserved, pinNothing},
+    {btnReserved, pinNothing}, {btnUnmapped, pinDigital},
+    {btnUnmapped, pinAnalog},  {btnUnmapped, pinAnalog},
+    {btnUnmapped, pinAnalog},  {btnUnmapped, pinAnalog}
+};
+
+const boardLayout_t genericLayout[] = {
+    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
+    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
+    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
+    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
+    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
+    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
+    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
+    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
+    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
+    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
+    {btnReserved, pinNothing}, {btnReserved, pinNothing}, // SCL/SDA
+    {btnUnmapped, pinDigital}, {btnReserved, pinNothing}, // 23, 24, 25
+    {btnReserved, pinNothing}, {btnReserved, pinNothing}, // are unused/unexposed
+    {btnUnmapped, pinAnalog},  {btnUnmapped, pinAnalog},  // ADC pins
+    {btnUnmapped, pinAnalog},  {-2, pinNothing}           // ADC, padding
+};
+
+// Pin header rows down each long side of a board picture, top to bottom,
+// following the old GUN4ALL pin grid (-1 for power/ground/unexposed positions).
+const int8_t rpipicoLeftHeader[] = {0, 1, -1, 2, 3, 4, 5, -1, 6, 7, 8, 9, -1, 10, 11, 12, 13, -1, 14, 15};
+const int8_t rpipicoRightHeader[] = {-1, -1, -1, -1, -1, -1, 28, -1, 27, 26, -1, 22, -1, -1, -1, 19, 18, -1, 17, 16};
+
+const int8_t adafruitItsyRP2040LeftHeader[] = {-1, -1, -1, -1, 26, 27, 28, 29, 24, 25, 18, 19, 20, 12, -1, -1};
+const int8_t adafruitItsyRP2040RightHeader[] = {-1, -1, -1, 11, 10, 9, 8, 7, 6, -1, -1, -1, 0, 1, -1, -1};
+
+const int8_t adafruitKB2040LeftHeader[] = {-1, 0, 1, -1, -1, -1, -1, 4, 5, 6, 7, 8, 9};
+const int8_t adafruitKB2040RightHeader[] = {-1, -1, -1, -1, -1, 29, 28, 27, 26, 18, 20, 19, 10};
+
+const int8_t arduinoNanoRP2040LeftHeader[] = {6, -1, -1, 26, 27, 28, 29, -1, -1, -1, -1, -1, -1, -1, -1};
+const int8_t arduinoNanoRP2040RightHeader[] = {4, 7, 5, 21, 20, 19, 18, 17, 16, 15, 25, -1, -1, 1, 0};
+
+// Board file names for each boardInputs_e, indexed by value (btnUnmapped = 0)
+static const char *const inputKeys[] = {
+    "unmapped",
+    "trigger", "a", "b", "c", "start", "select",
+    "up", "down", "left", "right",
+    "pedal", "home", "pump",
+    "rumble", "solenoid", "temp",
+    "rumbleSwitch", "solenoidSwitch", "autofireSwitch",
+    "ledR", "ledG", "ledB", "neoPixel",
+    "analogX", "analogY"
+};
+static_assert(sizeof(inputKeys) / sizeof(inputKeys[0]) == INPUTS_COUNT + 1, "inputKeys must cover every boardInputs_e");
+
+// Compiled-in boards can only be registered through this, so a layout with a missing
+// or extra pin fails the build instead of reading past the array at runtime.
+template<size_t N>
+static boardDef_s BuiltinBoard(const char *id, const char *name, const char *picture, const boardLayout_t (&layout)[N])
+{
+    static_assert(N == 30, "RP2040 board layouts must describe exactly 30 pins");
+    boardDef_s def;
+    def.id = id;
+    def.name = name;
+    def.picture = picture;
+    std::copy(layout, layout + N, def.layout);
+    std::fill(std::begin(def.pinAnchor), std::end(def.pinAnchor), QPointF(-1, -1));
+    return def;
+}
+
+// Spreads the header rows evenly between top and bottom (fractions of the picture height),
+// with the left/right rows inset from the edges by margin.
+template<size_t L, size_t R>
+static void HeaderAnchors(boardDef_s &def, const int8_t (&left)[L], const int8_t (&right)[R], qreal top, qreal bottom, qreal margin)
+{
+    for(size_t row = 0; row < L; row++) {
+        if(left[row] >= 0) {
+            def.pinAnchor[left[row]] = QPointF(margin, top + (row + 0.5) / L * (bottom - top));
+        }
+    }
+    for(size_t row = 0; row < R; row++) {
+        if(right[row] >= 0) {
+            def.pinAnchor[right[row]] = QPointF(1.0 - margin, top + (row + 0.5) / R * (bottom - top));
+        }
+    }
+}
+
+BoardRegistry::BoardRegistry()
+{
+    boardDef_s def = BuiltinBoard("rpipico", "Raspberry Pi Pico", ":/boardPics/pico.svg", rpipicoLayout);
+    HeaderAnchors(def, rpipicoLeftHeader, rpipicoRightHeader, 0.0, 1.0, 0.08);
+    Register(def);
+
+    def = BuiltinBoard("adafruitItsyRP2040", "Adafruit ItsyBitsy RP2040", ":/boardPics/adafruitItsy2040.svg", adafruitItsyRP2040Layout);
+    HeaderAnchors(def, adafruitItsyRP2040LeftHeader, adafruitItsyRP2040RightHeader, 0.0, 1.0, 0.08);
+    // the two extra pads along the bottom edge
+    def.pinAnchor[4] = QPointF(0.62, 0.96);
+    def.pinAnchor[5] = QPointF(0.38, 0.96);
+    Register(def);
+
+    def = BuiltinBoard("adafruitKB2040", "Adafruit KB2040", ":/boardPics/adafruitKB2040.svg", adafruitKB2040Layout);
+    HeaderAnchors(def, adafruitKB2040LeftHeader, adafruitKB2040RightHeader, 0.0, 1.0, 0.08);
+    Register(def);
+
+    def = BuiltinBoard("arduinoNanoRP2040", "Arduino Nano RP2040 Connect", ":/boardPics/arduinoNano2040.svg", arduinoNanoRP2040Layout);
+    HeaderAnchors(def, arduinoNanoRP2040LeftHeader, arduinoNanoRP2040RightHeader, 0.08, 0.92, 0.08);
+    Register(def);
+
+    // Same footprint as the Pico.
+    def = BuiltinBoard("generic", "LG2040", ":/boardPics/unknown.svg", genericLayout);
+    HeaderAnchors(def, rpipicoLeftHeader, rpipicoRightHeader, 0.0, 1.0, 0.08);
+    generic = Register(def);
+}
+
+const boardDef_s *BoardRegistry::Register(const boardDef_s &def)
+{
+    boards.push_back(def);
+    const boardDef_s *entry = &boards.back();
+    byId.insert(def.id, entry);
+    if(def.id == "generic") {
+        generic = entry;
+    }
+    return entry;
+}
+
+const boardDef_s *BoardRegistry::Find(const QString &id) const
+{
+    return byId.value(id, generic);
+}
+
+QVector<const boardDef_s*> BoardRegistry::All() const
+{
+    QVector<const boardDef_s*> all;
+    for(const boardDef_s &def : boards) {
+        // skip ones a board file has since replaced
+        if(byId.value(def.id) == &def) {
+            all.append(&def);
+        }
+    }
+    return all;
+}
+
+int BoardRegistry::LoadDir(const QString &dir)
+{
+    int loaded = 0;
+    const QFileInfoList files = QDir(dir).entryInfoList({"*.json"}, QDir::Files, QDir::Name);
+    for(const QFileInfo &file : files) {
+        if(LoadFile(file.absoluteFilePath())) {
+            loaded++;
+        }
+    }
+    if(loaded) {
+        qDebug() << "Loaded" << loaded << "board definitions from" << dir;
+    }
+    return loaded;
+}
+
+// Board files look like:
+// {
+//     "id": "lg2040mini",            <- what the firmware reports as its board
+//     "name": "LG2040 Mini",
+//     "picture": "lg2040mini.svg",   <- optional, relative to the board file
+//     "pins": [                      <- exactly 30, GPIO0 first
+//         { "type": "digital", "input": "trigger", "anchor": [0.1, 0.05] },
+//         { "type": "none" },        <- reserved/unexposed
+//         { "type": "analog" },      <- ADC capable, unmapped by default
+//         ...
+//     ]
+// }
+// "input" uses the names in inputKeys above and defaults to "unmapped".
+// "anchor" is where to mark the pin on the picture, as fractions of its width and height.
+bool BoardRegistry::LoadFile(const QString &path)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Couldn't open board file" << path;
+        return false;
+    }
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if(!doc.isObject()) {
+        qDebug() << "Board file" << path << "isn't valid JSON:" << parseError.errorString();
+        return false;
+    }
+    QJsonObject root = doc.object();
+
+    boardDef_s def;
+    def.id = root.value("id").toString();
+    def.name = root.value("name").toString(def.id);
+    if(def.id.isEmpty()) {
+        qDebug() << "Board file" << path << "has no id, skipping.";
+        return false;
+    }
+    if(root.contains("picture")) {
+        def.picture = QFileInfo(path).absoluteDir().filePath(root.value("picture").toString());
+    }
+
+    QJsonArray pins = root.value("pins").toArray();
+    if(pins.size() != 30) {
+        qDebug() << "Board file" << path << "has" << pins.size() << "pins, expected 30.";
+        return false;
+    }
+    uint32_t usedInputs = 0;
+    std::fill(std::begin(def.pinAnchor), std::end(def.pinAnchor), QPointF(-1, -1));
+    for(uint8_t i = 0; i < 30; i++) {
+        QJsonObject pin = pins[i].toObject();
+        QJsonArray anchor = pin.value("anchor").toArray();
+        if(anchor.size() == 2) {
+            def.pinAnchor[i] = QPointF(anchor[0].toDouble(), anchor[1].toDouble());
+        }
+        QString type = pin.value("type").toString("digital");
+        QString input = pin.value("input").toString("unmapped");
+
+        if(type == "none") {
+            def.layout[i] = {btnReserved, pinNothing};
+            continue;
+        } else if(type == "digital") {
+            def.layout[i].pinType = pinDigital;
+        } else if(type == "analog") {
+            def.layout[i].pinType = pinAnalog;
+        } else {
+            qDebug() << "Board file" << path << "GPIO" << i << "has unknown type" << type;
+            return false;
+        }
+
+        const char *const *key = std::find(std::begin(inputKeys), std::end(inputKeys), input);
+        if(key == std::end(inputKeys)) {
+            qDebug() << "Board file" << path << "GPIO" << i << "has unknown input" << input;
+            return false;
+        }
+        int8_t value = key - std::begin(inputKeys);
+        if(value > btnUnmapped) {
+            uint32_t bit = 1u << (value - 1);
+            if(usedInputs & bit) {
+                qDebug() << "Board file" << path << "maps" << input << "more than once.";
+                return false;
+            }
+            if((analogOnlyInputs & bit) && def.layout[i].pinType != pinAnalog) {
+                qDebug() << "Board file" << path << "puts" << input << "on non-ADC GPIO" << i;
+                return false;
+            }
+            usedInputs |= bit;
+        }
+        def.layout[i].pinAssignment = value;
+    }
+
+    Register(def);
+    return true;
+}
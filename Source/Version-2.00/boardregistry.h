@@ -0,0 +1,73 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BOARDREGISTRY_H
+#define BOARDREGISTRY_H
+
+#include "constants.h"
+#include <QHash>
+#include <QPointF>
+#include <QString>
+#include <QVector>
+#include <deque>
+
+// Everything the GUI knows about one kind of board.
+typedef struct boardDef_t {
+    // Board id as reported by the firmware's "XP" response, e.g. "rpipico"
+    QString id;
+    // Human-readable name for the board label
+    QString name;
+    // Board picture (resource or file path), empty if there isn't one
+    QString picture;
+    boardLayout_t layout[30];
+    // Where each pin sits on the picture, as a fraction of its width/height;
+    // negative if the pin isn't drawn.
+    QPointF pinAnchor[30];
+} boardDef_s;
+
+// Lookup of every supported board by firmware id.
+// Compiled-in boards are always present; extra ones come from *.json board files,
+// so new LG2040 variants don't need a rebuild.
+class BoardRegistry
+{
+public:
+    BoardRegistry();
+
+    // Loads every *.json board file in dir, replacing compiled-in boards with the same id.
+    // Returns the amount of boards loaded; bad files are skipped with a debug message.
+    int LoadDir(const QString &dir);
+
+    // Board for the given firmware id, or the generic RP2040 board if we don't know it.
+    const boardDef_s *Find(const QString &id) const;
+
+    const boardDef_s *Generic() const { return generic; }
+
+    // Every known board, compiled-in ones first.
+    QVector<const boardDef_s*> All() const;
+
+private:
+    bool LoadFile(const QString &path);
+
+    const boardDef_s *Register(const boardDef_s &def);
+
+    // Owns the definitions; deque so pointers handed out stay valid as boards get added.
+    std::deque<boardDef_s> boards;
+    QHash<QString, const boardDef_s*> byId;
+    const boardDef_s *generic;
+};
+
+#endif // BOARDREGISTRY_H
@@ -0,0 +1,155 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "boardview.h"
+#include "boardregistry.h"
+#include <QElapsedTimer>
+#include <QPainter>
+#include <QSvgRenderer>
+#include <QtDebug>
+
+// Marker size, relative to the picture's width
+#define MARKER_SCALE 0.09
+
+BoardView::BoardView(QWidget *parent)
+    : QWidget(parent)
+{
+    mapping.Clear();
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    setMinimumWidth(120);
+}
+
+QSize BoardView::sizeHint() const
+{
+    return QSize(200, 400);
+}
+
+void BoardView::SetBoard(const boardDef_t *def)
+{
+    board = def;
+    activeInputs = 0;
+    if(board && !board->picture.isEmpty() && !pictureSizes.contains(board->picture)) {
+        // Only the natural size is needed up front; the actual render waits for a paint.
+        QSvgRenderer renderer(board->picture);
+        if(!renderer.isValid()) {
+            qDebug() << "Couldn't load board picture" << board->picture;
+        }
+        pictureSizes.insert(board->picture, renderer.viewBoxF().size());
+    }
+    update();
+}
+
+void BoardView::SetMapping(const pinMap_s &map)
+{
+    mapping = map;
+    update();
+}
+
+void BoardView::SetInputActive(uint8_t input, bool active)
+{
+    if(!board || input <= btnUnmapped || input > INPUTS_COUNT) {
+        return;
+    }
+    uint32_t bit = 1u << (input - 1);
+    if(bool(activeInputs & bit) == active) {
+        return;
+    }
+    activeInputs ^= bit;
+    // Only the one marker needs repainting.
+    if(mapping.inputPin[input - 1] >= 0) {
+        update(MarkerRect(mapping.inputPin[input - 1]));
+    }
+}
+
+QRect BoardView::PictureRect() const
+{
+    if(!board || !pictureSizes.contains(board->picture)) {
+        return QRect();
+    }
+    QSize picture = pictureSizes.value(board->picture).toSize();
+    if(picture.isEmpty()) {
+        return QRect();
+    }
+    picture.scale(size(), Qt::KeepAspectRatio);
+    return QRect(QPoint((width() - picture.width()) / 2, (height() - picture.height()) / 2), picture);
+}
+
+QRect BoardView::MarkerRect(uint8_t pin) const
+{
+    QRect picture = PictureRect();
+    const QPointF &anchor = board->pinAnchor[pin];
+    int diameter = qMax(6, int(picture.width() * MARKER_SCALE));
+    QPoint center(picture.left() + qRound(anchor.x() * picture.width()), picture.top() + qRound(anchor.y() * picture.height()));
+    // one extra pixel each way for the outline
+    return QRect(center - QPoint(diameter / 2 + 1, diameter / 2 + 1), QSize(diameter + 2, diameter + 2));
+}
+
+void BoardView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QRect picture = PictureRect();
+    if(picture.isEmpty()) {
+        return;
+    }
+
+    qreal dpr = devicePixelRatioF();
+    QSize pixels = picture.size() * dpr;
+    boardRaster_s &raster = rasters[board->picture];
+    if(raster.renderedFor != pixels) {
+        // Only hit the first time a board is shown at this size.
+        QElapsedTimer renderTimer;
+        renderTimer.start();
+        raster.image = QImage(pixels, QImage::Format_ARGB32_Premultiplied);
+        raster.image.fill(Qt::transparent);
+        QPainter svgPainter(&raster.image);
+        QSvgRenderer(board->picture).render(&svgPainter);
+        svgPainter.end();
+        raster.image.setDevicePixelRatio(dpr);
+        raster.renderedFor = pixels;
+        qDebug() << "Rasterised" << board->picture << "at" << pixels << "in" << renderTimer.elapsed() << "ms";
+    }
+
+    QPainter painter(this);
+    painter.drawImage(picture.topLeft(), raster.image);
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    for(uint32_t pins = mapping.occupiedPins; pins; pins &= pins - 1) {
+        uint8_t pin = 0;
+        while(!(pins & (1u << pin))) {
+            pin++;
+        }
+        if(board->pinAnchor[pin].x() < 0) {
+            continue;
+        }
+        uint8_t input = mapping.pinInput[pin];
+        bool active = activeInputs & (1u << (input - 1));
+        // Outputs and inputs get different colours; held buttons light up.
+        QColor color;
+        if(active) {
+            color = QColor(255, 230, 60);
+        } else if(input >= rumblePin && input <= tempPin) {
+            color = QColor(230, 90, 60, 200);
+        } else if(input >= ledR && input <= neoPixel) {
+            color = QColor(170, 100, 230, 200);
+        } else {
+            color = QColor(60, 160, 230, 200);
+        }
+        painter.setPen(QPen(Qt::black, 1));
+        painter.setBrush(color);
+        painter.drawEllipse(MarkerRect(pin).adjusted(1, 1, -1, -1));
+    }
+}
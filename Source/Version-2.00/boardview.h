@@ -0,0 +1,73 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BOARDVIEW_H
+#define BOARDVIEW_H
+
+#include "pinmap.h"
+#include <QHash>
+#include <QImage>
+#include <QWidget>
+
+struct boardDef_t;
+
+// Picture of the connected board with its mapped pins marked on top.
+// Each board SVG is rasterised once per widget size and kept, so repaints
+// (e.g. a button lighting up its pin in test mode) only blit the image and draw a few dots.
+class BoardView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit BoardView(QWidget *parent = nullptr);
+
+    void SetBoard(const boardDef_t *def);
+
+    // Mapping to mark on the board; call again whenever it changes.
+    void SetMapping(const pinMap_s &map);
+
+    // Lights up (or dims) the pin an input is on, e.g. from the test mode's Pressed/Released.
+    void SetInputActive(uint8_t input, bool active);
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    typedef struct boardRaster_t {
+        QImage image;
+        QSize renderedFor;
+    } boardRaster_s;
+
+    // Where the board picture sits in the widget, keeping its aspect ratio
+    QRect PictureRect() const;
+
+    // Widget area covered by a pin's marker
+    QRect MarkerRect(uint8_t pin) const;
+
+    const boardDef_t *board = nullptr;
+    pinMap_s mapping;
+    // Inputs currently held down (bit = boardInputs_e - 1)
+    uint32_t activeInputs = 0;
+
+    // Keyed by picture path, so flipping between boards doesn't re-render either one.
+    QHash<QString, boardRaster_s> rasters;
+    QHash<QString, QSizeF> pictureSizes;
+};
+
+#endif // BOARDVIEW_H
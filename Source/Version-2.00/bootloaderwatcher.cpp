@@ -0,0 +1,173 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "bootloaderwatcher.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSerialPort>
+#include <QSerialPortInfo>
+#include <QStorageInfo>
+#include <QTimer>
+#include <QtDebug>
+
+BootloaderWatcher::BootloaderWatcher(QObject *parent)
+    : QObject(parent)
+{
+    watcher = new QFileSystemWatcher(this);
+    connect(watcher, &QFileSystemWatcher::directoryChanged, this, &BootloaderWatcher::Check);
+    poll = new QTimer(this);
+    poll->setInterval(BOOTLOADER_POLL_MS);
+    connect(poll, &QTimer::timeout, this, &BootloaderWatcher::Check);
+}
+
+
+QString BootloaderWatcher::StandIn()
+{
+    const QString dir = qEnvironmentVariable("PIGS_BOOTLOADER_DIR");
+    if(dir.isEmpty() || !QFileInfo::exists(QDir(dir).filePath("INFO_UF2.TXT"))) {
+        return QString();
+    }
+    return QDir(dir).absolutePath();
+}
+
+
+QStringList BootloaderWatcher::Mounted()
+{
+    QStringList found;
+    if(!StandIn().isEmpty()) {
+        found.append(StandIn());
+    }
+    for(const QStorageInfo &storage : QStorageInfo::mountedVolumes()) {
+        // The label shows up before the file system is readable; INFO_UF2.TXT means it's ready for a UF2.
+        if(storage.isValid() && storage.isReady() && storage.name() == BOOTLOADER_LABEL &&
+           QFileInfo::exists(QDir(storage.rootPath()).filePath("INFO_UF2.TXT"))) {
+            found.append(storage.rootPath());
+        }
+    }
+    return found;
+}
+
+
+void BootloaderWatcher::Start(int timeoutMs)
+{
+    Stop();
+    if(timeoutMs <= 0) {
+        bool ok;
+        timeoutMs = qEnvironmentVariableIntValue("PIGS_BOOTLOADER_TIMEOUT_MS", &ok);
+        if(!ok || timeoutMs <= 0) {
+            timeoutMs = BOOTLOADER_TIMEOUT_MS;
+        }
+    }
+    this->timeoutMs = timeoutMs;
+    const QStringList mounted = Mounted();
+    known = QSet<QString>(mounted.begin(), mounted.end());
+
+    // Where a new drive makes itself known: its device node, then its automount point.
+    QStringList dirs;
+#if defined(Q_OS_MACOS)
+    dirs << "/Volumes";
+#elif defined(Q_OS_UNIX)
+    QString user = qEnvironmentVariable("USER");
+    dirs << "/dev" << "/media" << "/media/" + user << "/run/media/" + user << "/mnt";
+#endif
+    for(const QString &dir : dirs) {
+        if(QFileInfo(dir).isDir()) {
+            watcher->addPath(dir);
+        }
+    }
+    timer.start();
+    poll->start();
+}
+
+
+bool BootloaderWatcher::Reset(const QSerialPortInfo &port, int timeoutMs)
+{
+    Stop();
+    // The firmware reboots when DTR drops while the line is set to 1200 baud,
+    // so the port has to be opened at 1200 first; changing the rate of an open port isn't enough.
+    QSerialPort touch;
+    touch.setPort(port);
+    touch.setBaudRate(QSerialPort::Baud1200);
+    if(!touch.open(QIODevice::ReadWrite)) {
+        qDebug() << "Couldn't open" << port.systemLocation() << "for the bootloader reset:" << touch.errorString();
+        return false;
+    }
+    touch.setDataTerminalReady(false);
+    touch.close();
+
+    Start(timeoutMs);
+    resetPort = port.systemLocation();
+    poll->setInterval(BOOTLOADER_RESET_POLL_MS);
+    return true;
+}
+
+
+void BootloaderWatcher::Stop()
+{
+    resetPort.clear();
+    poll->stop();
+    poll->setInterval(BOOTLOADER_POLL_MS);
+    if(!watcher->directories().isEmpty()) {
+        watcher->removePaths(watcher->directories());
+    }
+}
+
+
+bool BootloaderWatcher::IsWaiting() const
+{
+    return poll->isActive();
+}
+
+
+void BootloaderWatcher::Check()
+{
+    if(!IsWaiting()) {
+        return;
+    }
+    if(!resetPort.isEmpty()) {
+        const QList<QSerialPortInfo> ports = QSerialPortInfo::availablePorts();
+        bool present = false;
+        for(const QSerialPortInfo &port : ports) {
+            present |= port.systemLocation() == resetPort;
+        }
+        if(present) {
+            if(timer.elapsed() >= BOOTLOADER_RESET_MS) {
+                Stop();
+                emit ResetFailed();
+            }
+            return;
+        }
+        qDebug() << resetPort << "went away" << timer.elapsed() << "ms after the reset";
+        resetPort.clear();
+        poll->setInterval(BOOTLOADER_POLL_MS);
+        emit PortGone(timer.elapsed());
+    }
+    for(const QString &path : Mounted()) {
+        if(!known.contains(path)) {
+            qint64 elapsed = timer.elapsed();
+            Stop();
+            qDebug() << "Bootloader drive mounted at" << path << "after" << elapsed << "ms";
+            emit Found(path, elapsed);
+            return;
+        }
+    }
+    if(timer.elapsed() >= timeoutMs) {
+        Stop();
+        emit TimedOut(timer.elapsed());
+    }
+}
@@ -0,0 +1,91 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BOOTLOADERWATCHER_H
+#define BOOTLOADERWATCHER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+class QFileSystemWatcher;
+class QSerialPortInfo;
+class QTimer;
+
+// Volume label of the RP2040 bootloader's mass storage drive
+#define BOOTLOADER_LABEL "RPI-RP2"
+// How long to wait for the drive by default; PIGS_BOOTLOADER_TIMEOUT_MS overrides it
+#define BOOTLOADER_TIMEOUT_MS 20000
+// Rescan interval, for mounts the file system watcher doesn't catch (and for Windows, where it has nothing to watch)
+#define BOOTLOADER_POLL_MS 250
+// Rescan interval while waiting for a reset gun's serial port to go away
+#define BOOTLOADER_RESET_POLL_MS 20
+// How long a gun gets to drop off the bus after the 1200 baud touch before the reset counts as failed
+#define BOOTLOADER_RESET_MS 3000
+
+// Waits for an RP2040 bootloader drive to show up and get mounted, without blocking:
+// device and automount directories are watched for changes, with a slow poll as a backstop.
+// Only drives that weren't already mounted when the wait started count.
+class BootloaderWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BootloaderWatcher(QObject *parent = nullptr);
+
+    // Starts (or restarts) waiting; timeoutMs <= 0 uses the default.
+    void Start(int timeoutMs = 0);
+
+    void Stop();
+
+    // Reboots the gun on port into its bootloader with a 1200 baud touch, then waits for its
+    // port to go away (ResetFailed if it doesn't) and its drive to show up, as with Start().
+    // False if the port couldn't be opened at all.
+    bool Reset(const QSerialPortInfo &port, int timeoutMs = 0);
+
+    bool IsWaiting() const;
+
+    // Root paths of every bootloader drive mounted right now.
+    static QStringList Mounted();
+
+    // Plain directory standing in for the drive (PIGS_BOOTLOADER_DIR), for working on
+    // flashing without a gun; empty unless it's set and has an INFO_UF2.TXT.
+    static QString StandIn();
+
+signals:
+    // The reset gun's serial port went away, i.e. it took the reset.
+    void PortGone(qint64 elapsedMs);
+    void ResetFailed();
+    void Found(const QString &mountPath, qint64 elapsedMs);
+    void TimedOut(qint64 elapsedMs);
+
+private slots:
+    void Check();
+
+private:
+    QFileSystemWatcher *watcher;
+    QTimer *poll;
+    QElapsedTimer timer;
+    int timeoutMs = BOOTLOADER_TIMEOUT_MS;
+    // Drives already mounted when the wait started
+    QSet<QString> known;
+    // Serial port of the gun being reset, until it's gone
+    QString resetPort;
+};
+
+#endif // BOOTLOADERWATCHER_H
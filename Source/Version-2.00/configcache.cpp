@@ -0,0 +1,248 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "configcache.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtDebug>
+
+// Bumped whenever gunConfig_s or the file format changes, so old caches get ignored.
+#define CONFIG_CACHE_VERSION 2
+
+static void HashBytes(uint64_t &hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = static_cast<const uint8_t*>(data);
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+}
+
+template<typename T>
+static void HashValue(uint64_t &hash, T value)
+{
+    HashBytes(hash, &value, sizeof(value));
+}
+
+static void HashString(uint64_t &hash, const QString &string)
+{
+    QByteArray utf8 = string.toUtf8();
+    HashValue(hash, static_cast<uint32_t>(utf8.size()));
+    HashBytes(hash, utf8.constData(), utf8.size());
+}
+
+uint64_t ConfigHash(const gunConfig_s &config)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for(uint8_t field = 0; field < fieldsCount; field++) {
+        const fieldDef_s &def = configSchema[field];
+        switch(def.kind) {
+        case fieldKindBool:
+        case fieldKindPin:
+            HashValue(hash, static_cast<int8_t>(FieldStored(config, field)));
+            break;
+        case fieldKindNumber:
+            if(def.size == 2) {
+                HashValue(hash, static_cast<uint16_t>(FieldStored(config, field)));
+            } else {
+                HashValue(hash, static_cast<uint8_t>(FieldStored(config, field)));
+            }
+            break;
+        case fieldKindText:
+            HashString(hash, FieldString(config, field));
+            break;
+        }
+    }
+    return hash;
+}
+
+gunConfig_s ConfigDefaults()
+{
+    gunConfig_s config;
+    config.Clear();
+    for(uint8_t i = 0; i < 8; i++) {
+        config.bools[i] = boolDefaults[i];
+        config.settings[i] = settingsDefaults[i];
+    }
+    return config;
+}
+
+QJsonObject ConfigToJson(const gunConfig_s &config)
+{
+    QJsonArray bools, settings, pins, profiles;
+    for(uint8_t i = 0; i < 8; i++) {
+        bools.append(config.bools[i]);
+        settings.append(config.settings[i]);
+    }
+    for(uint8_t i = 0; i < INPUTS_COUNT; i++) {
+        pins.append(FieldStored(config, fieldInputPin + i));
+    }
+    for(uint8_t slot = 0; slot < 4; slot++) {
+        QJsonArray profile;
+        for(uint8_t i = 0; i < profileFieldsCount; i++) {
+            profile.append(FieldGet(config, fieldProfile + slot * profileFieldsCount + i));
+        }
+        profiles.append(profile);
+    }
+
+    QJsonObject obj;
+    obj["bools"] = bools;
+    obj["settings"] = settings;
+    obj["pins"] = pins;
+    obj["profiles"] = profiles;
+    obj["tinyUSBid"] = FieldString(config, fieldTinyUSBid);
+    obj["tinyUSBname"] = FieldString(config, fieldTinyUSBname);
+    return obj;
+}
+
+bool ConfigFromJson(const QJsonObject &obj, gunConfig_s &config)
+{
+    QJsonArray bools = obj["bools"].toArray();
+    QJsonArray settings = obj["settings"].toArray();
+    QJsonArray pins = obj["pins"].toArray();
+    QJsonArray profiles = obj["profiles"].toArray();
+    if(bools.size() != 8 || settings.size() != 8 || pins.size() != INPUTS_COUNT || profiles.size() != 4) {
+        return false;
+    }
+
+    config.Clear();
+    for(uint8_t i = 0; i < 8; i++) {
+        config.bools[i] = bools[i].toBool();
+        config.settings[i] = settings[i].toInt();
+    }
+    if(config.bools[customPins]) {
+        for(uint8_t i = 0; i < INPUTS_COUNT; i++) {
+            FieldSet(config, fieldInputPin + i, pins[i].toInt(-1));
+        }
+    }
+    for(uint8_t slot = 0; slot < 4; slot++) {
+        QJsonArray profile = profiles[slot].toArray();
+        if(profile.size() != profileFieldsCount) {
+            return false;
+        }
+        for(uint8_t i = 0; i < profileFieldsCount; i++) {
+            FieldSet(config, fieldProfile + slot * profileFieldsCount + i, profile[i].toInt());
+        }
+    }
+    FieldSetString(config, fieldTinyUSBid, obj["tinyUSBid"].toString());
+    FieldSetString(config, fieldTinyUSBname, obj["tinyUSBname"].toString());
+    return true;
+}
+
+static QJsonObject EntryToJson(const configCacheEntry_s &entry)
+{
+    QJsonObject obj = ConfigToJson(entry.config);
+    obj["firmware"] = entry.firmware;
+    obj["board"] = entry.boardId;
+    obj["hash"] = QString::number(entry.hash, 16);
+    return obj;
+}
+
+static bool EntryFromJson(const QJsonObject &obj, configCacheEntry_s &entry)
+{
+    if(!ConfigFromJson(obj, entry.config)) {
+        return false;
+    }
+    entry.firmware = obj["firmware"].toString();
+    entry.boardId = obj["board"].toString();
+    bool ok;
+    entry.hash = obj["hash"].toString().toULongLong(&ok, 16);
+    // Anything mangled on disk won't hash the same, and a wrong cache is worse than none.
+    return ok && entry.hash == ConfigHash(entry.config);
+}
+
+void ConfigCache::Load(const QString &path)
+{
+    this->path = path;
+    entries.clear();
+
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if(root["version"].toInt() != CONFIG_CACHE_VERSION) {
+        qDebug() << "Ignoring config cache from another version:" << path;
+        return;
+    }
+    QJsonObject guns = root["guns"].toObject();
+    for(auto it = guns.constBegin(); it != guns.constEnd(); ++it) {
+        configCacheEntry_s entry;
+        if(EntryFromJson(it.value().toObject(), entry)) {
+            entries.insert(it.key(), entry);
+        } else {
+            qDebug() << "Dropping bad config cache entry for" << it.key();
+        }
+    }
+}
+
+const configCacheEntry_s *ConfigCache::Last(const QString &key) const
+{
+    auto it = entries.constFind(key);
+    return it == entries.constEnd() ? nullptr : &it.value();
+}
+
+void ConfigCache::Store(const QString &key, configCacheEntry_s entry)
+{
+    if(key.isEmpty()) {
+        return;
+    }
+    entry.hash = ConfigHash(entry.config);
+    auto it = entries.constFind(key);
+    if(it != entries.constEnd() && it->hash == entry.hash && it->firmware == entry.firmware &&
+       it->boardId == entry.boardId) {
+        return;
+    }
+    entries.insert(key, entry);
+    Save();
+}
+
+void ConfigCache::Forget(const QString &key)
+{
+    if(entries.remove(key)) {
+        Save();
+    }
+}
+
+bool ConfigCache::Save() const
+{
+    if(path.isEmpty()) {
+        return false;
+    }
+    QJsonObject guns;
+    for(auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        guns[it.key()] = EntryToJson(it.value());
+    }
+    QJsonObject root;
+    root["version"] = CONFIG_CACHE_VERSION;
+    root["guns"] = guns;
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    // Written aside and swapped in, so a crash mid-write can't leave half a cache behind.
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Couldn't write config cache" << path;
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
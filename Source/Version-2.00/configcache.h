@@ -0,0 +1,74 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CONFIGCACHE_H
+#define CONFIGCACHE_H
+
+#include "configfields.h"
+#include <QHash>
+#include <QJsonObject>
+#include <QString>
+
+// 64-bit FNV-1a over every configSchema field as the gun stores it, so padding never leaks in.
+uint64_t ConfigHash(const gunConfig_s &config);
+
+// Config of a freshly flashed gun, per the defaults in constants.h.
+gunConfig_s ConfigDefaults();
+
+QJsonObject ConfigToJson(const gunConfig_s &config);
+
+// False if obj is missing any part of a config.
+bool ConfigFromJson(const QJsonObject &obj, gunConfig_s &config);
+
+// Last known config of one gun.
+typedef struct configCacheEntry_t {
+    // Firmware version + codename it was read under; a reflash invalidates the entry
+    QString firmware;
+    // Board id the gun reported, so its config can be edited offline on the right layout
+    QString boardId;
+    uint64_t hash = 0;
+    gunConfig_s config;
+} configCacheEntry_s;
+
+// Per-gun cache of the last config read from (or written to) each gun, keyed by
+// USB serial number or TinyUSB id, so a gun's config can be edited and queued while it's unplugged.
+// Kept as one small JSON file; entries that fail their hash check on load are dropped.
+class ConfigCache
+{
+public:
+    // Reads the cache file at path; a missing or broken file just starts out empty.
+    void Load(const QString &path);
+
+    // Stamps entry's hash and writes it out, unless the cache already has exactly that.
+    void Store(const QString &key, configCacheEntry_s entry);
+
+    void Forget(const QString &key);
+
+    // Every gun we have a config for.
+    QStringList Keys() const { return entries.keys(); }
+
+    // Latest entry for key regardless of firmware, or nullptr.
+    const configCacheEntry_s *Last(const QString &key) const;
+
+private:
+    bool Save() const;
+
+    QString path;
+    QHash<QString, configCacheEntry_s> entries;
+};
+
+#endif // CONFIGCACHE_H
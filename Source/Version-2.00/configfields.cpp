@@ -0,0 +1,68 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "configfields.h"
+
+QString FieldString(const gunConfig_s &config, uint8_t field)
+{
+    const fieldDef_s &def = configSchema[field];
+    const char *at = reinterpret_cast<const char*>(&config) + def.offset;
+    return QString::fromUtf8(at, strnlen(at, def.size));
+}
+
+
+bool FieldSetString(gunConfig_s &config, uint8_t field, const QString &text)
+{
+    const fieldDef_s &def = configSchema[field];
+    char *at = reinterpret_cast<char*>(&config) + def.offset;
+    const QByteArray utf8 = text.toUtf8();
+    int length = qMin<int>(utf8.size(), def.size - 1);
+    // Never split a character: back off to the start of the one that doesn't fit.
+    if(length < utf8.size()) {
+        while(length > 0 && (uchar(utf8[length]) & 0xC0) == 0x80) {
+            length--;
+        }
+    }
+    memset(at, 0, def.size);
+    memcpy(at, utf8.constData(), length);
+    return length == utf8.size();
+}
+
+
+bool FieldEqual(const gunConfig_s &a, const gunConfig_s &b, uint8_t field)
+{
+    const fieldDef_s &def = configSchema[field];
+    if(def.kind == fieldKindText) {
+        return strncmp(reinterpret_cast<const char*>(&a) + def.offset,
+                       reinterpret_cast<const char*>(&b) + def.offset, def.size) == 0;
+    }
+    return FieldStored(a, field) == FieldStored(b, field);
+}
+
+
+QString FieldWrite(const gunConfig_s &config, uint8_t field)
+{
+    const fieldDef_s &def = configSchema[field];
+    if(!def.group) {
+        return "";
+    } else if(def.kind == fieldKindText) {
+        return QString("Xm.%1.%2.%3").arg(QChar(def.group)).arg(def.index).arg(FieldString(config, field));
+    } else if(def.letter) {
+        return QString("Xm.%1.%2.%3.%4").arg(QChar(def.group)).arg(QChar(def.letter)).arg(def.index).arg(FieldStored(config, field));
+    }
+    return QString("Xm.%1.%2.%3").arg(QChar(def.group)).arg(def.index).arg(FieldStored(config, field));
+}
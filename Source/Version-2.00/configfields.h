@@ -0,0 +1,261 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CONFIGFIELDS_H
+#define CONFIGFIELDS_H
+
+#include "constants.h"
+#include "pinmap.h"
+#include <QString>
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+// Room kept for the TinyUSB ident, terminator included; longer ones get cut short.
+#define TINYUSB_ID_SIZE 16
+#define TINYUSB_NAME_SIZE 32
+
+enum profileFields_e {
+    profileXScale = 0,
+    profileYScale,
+    profileXCenter,
+    profileYCenter,
+    profileIrSensitivity,
+    profileRunMode,
+    profileFieldsCount
+};
+
+// Every individually tracked value of a gun's config, flattened into one index space
+// so per-field bookkeeping (dirty bits, history) can be a plain bitset or array.
+enum configFields_e {
+    // + boolTypes_e
+    fieldBool = 0,
+    // + settingsTypes_e
+    fieldSetting = fieldBool + 8,
+    // + boardInputs_e - 1; value is the pin number, -1 if unmapped
+    fieldInputPin = fieldSetting + 8,
+    fieldTinyUSBid = fieldInputPin + INPUTS_COUNT,
+    fieldTinyUSBname,
+    fieldSelectedProfile,
+    // + slot * profileFieldsCount + profileFields_e
+    fieldProfile,
+    fieldsCount = fieldProfile + 4 * profileFieldsCount
+};
+
+typedef std::bitset<fieldsCount> configFieldSet_t;
+
+// A gun's whole config as one plain struct: snapshots are a copy, "anything changed?" a memcmp.
+// Globals and Clear()ed configs start with zeroed padding, and copies carry it along,
+// so two configs that were never edited apart compare equal byte for byte.
+typedef struct gunConfig_t {
+    bool bools[8];
+    uint16_t settings[8];
+    // Custom pin mapping. The gun only keeps it with customPins on;
+    // the editor's working copy holds the board's default wiring otherwise.
+    pinMap_s pins;
+    profilesTable_s profiles[4];
+    // NUL-terminated
+    char tinyUSBid[TINYUSB_ID_SIZE];
+    char tinyUSBname[TINYUSB_NAME_SIZE];
+
+    void Clear()
+    {
+        memset(this, 0, sizeof(*this));
+        pins.Clear();
+    }
+} gunConfig_s;
+
+static_assert(std::is_trivially_copyable<gunConfig_s>::value, "gunConfig_s must stay a plain copyable struct");
+static_assert(std::is_standard_layout<gunConfig_s>::value, "configSchema offsets need a standard layout gunConfig_s");
+
+enum fieldKinds_e {
+    fieldKindBool = 0,
+    fieldKindNumber,
+    // int8_t pin number, -1 if unmapped
+    fieldKindPin,
+    // char array of size bytes
+    fieldKindText,
+    // Not part of gunConfig_s (profile selection lives in boardInfo_t)
+    fieldKindBoard
+};
+
+// Where a configFields_e lives in gunConfig_s and how it's written to the gun.
+typedef struct fieldDef_t {
+    uint8_t kind;
+    uint16_t offset;
+    uint8_t size;
+    // Xm write: "Xm.<group>.<index>.<value>", or "Xm.P.<letter>.<index>.<value>" for profiles
+    // (index being the slot then); group is 0 for fields that aren't written.
+    char group;
+    char letter;
+    uint8_t index;
+} fieldDef_s;
+
+// Profile write letters, by profileFields_e. Scales and centers have none: they only
+// come from calibrating on the gun, which has no command to set them.
+constexpr char profileLetters[profileFieldsCount] = { 0, 0, 0, 0, 'i', 'r' };
+
+constexpr size_t profileOffsets[profileFieldsCount] = {
+    offsetof(profilesTable_s, xScale),
+    offsetof(profilesTable_s, yScale),
+    offsetof(profilesTable_s, xCenter),
+    offsetof(profilesTable_s, yCenter),
+    offsetof(profilesTable_s, irSensitivity),
+    offsetof(profilesTable_s, runMode)
+};
+
+constexpr std::array<fieldDef_s, fieldsCount> ConfigSchemaBuild()
+{
+    std::array<fieldDef_s, fieldsCount> schema{};
+    for(uint8_t i = 0; i < 8; i++) {
+        // customPins is sent along with the pins, the other bools shift down one to fill its spot
+        schema[fieldBool + i] = { fieldKindBool, uint16_t(offsetof(gunConfig_s, bools) + i), 1,
+                                  i == customPins ? '1' : '0', 0, uint8_t(i == customPins ? 0 : i - 1) };
+        schema[fieldSetting + i] = { fieldKindNumber, uint16_t(offsetof(gunConfig_s, settings) + i * sizeof(uint16_t)), 2,
+                                     '2', 0, i };
+    }
+    for(uint8_t i = 0; i < INPUTS_COUNT; i++) {
+        schema[fieldInputPin + i] = { fieldKindPin, uint16_t(offsetof(gunConfig_s, pins) + offsetof(pinMap_s, inputPin) + i), 1,
+                                      '1', 0, uint8_t(i + 1) };
+    }
+    schema[fieldTinyUSBid] = { fieldKindText, uint16_t(offsetof(gunConfig_s, tinyUSBid)), TINYUSB_ID_SIZE, '3', 0, 0 };
+    schema[fieldTinyUSBname] = { fieldKindText, uint16_t(offsetof(gunConfig_s, tinyUSBname)), TINYUSB_NAME_SIZE, '3', 0, 1 };
+    schema[fieldSelectedProfile] = { fieldKindBoard, 0, 0, 0, 0, 0 };
+    for(uint8_t slot = 0; slot < 4; slot++) {
+        for(uint8_t i = 0; i < profileFieldsCount; i++) {
+            schema[fieldProfile + slot * profileFieldsCount + i] = {
+                fieldKindNumber,
+                uint16_t(offsetof(gunConfig_s, profiles) + slot * sizeof(profilesTable_s) + profileOffsets[i]),
+                uint8_t(i < profileIrSensitivity ? 2 : 1), char(profileLetters[i] ? 'P' : 0), profileLetters[i], slot };
+        }
+    }
+    return schema;
+}
+
+// Every configFields_e, in the order the gun reports them. The parser, writer, diff,
+// cache and widget code all walk this rather than knowing the struct themselves.
+constexpr std::array<fieldDef_s, fieldsCount> configSchema = ConfigSchemaBuild();
+
+static_assert(configSchema[fieldProfile + 3 * profileFieldsCount + profileRunMode].offset == offsetof(gunConfig_s, profiles) + sizeof(profilesTable_s) * 4 - 1,
+              "profile fields must cover profilesTable_s exactly");
+
+// Raw value of a numeric field in config. Pins read as held, even with customPins off.
+inline int32_t FieldGet(const gunConfig_s &config, uint8_t field)
+{
+    const fieldDef_s &def = configSchema[field];
+    const uint8_t *at = reinterpret_cast<const uint8_t*>(&config) + def.offset;
+    switch(def.kind) {
+    case fieldKindBool:
+        return *reinterpret_cast<const bool*>(at);
+    case fieldKindPin:
+        return static_cast<int8_t>(*at);
+    case fieldKindNumber:
+        if(def.size == 2) {
+            uint16_t value;
+            memcpy(&value, at, sizeof(value));
+            return value;
+        }
+        return *at;
+    default:
+        return 0;
+    }
+}
+
+// Value of a numeric field as the gun keeps it: pins are all unmapped with customPins off.
+inline int32_t FieldStored(const gunConfig_s &config, uint8_t field)
+{
+    if(configSchema[field].kind == fieldKindPin && !config.bools[customPins]) {
+        return -1;
+    }
+    return FieldGet(config, field);
+}
+
+// Sets a numeric field. Pins go through the mapping, so both of its directions stay in step.
+inline void FieldSet(gunConfig_s &config, uint8_t field, int32_t value)
+{
+    const fieldDef_s &def = configSchema[field];
+    uint8_t *at = reinterpret_cast<uint8_t*>(&config) + def.offset;
+    switch(def.kind) {
+    case fieldKindBool:
+        *reinterpret_cast<bool*>(at) = value;
+        break;
+    case fieldKindPin: {
+        uint8_t input = field - fieldInputPin + 1;
+        if(value >= 0 && value < 30) {
+            config.pins.Assign(value, input);
+        } else if(config.pins.inputPin[input - 1] >= 0) {
+            config.pins.UnassignPin(config.pins.inputPin[input - 1]);
+        }
+        break;
+    }
+    case fieldKindNumber:
+        if(def.size == 2) {
+            uint16_t narrowed = value;
+            memcpy(at, &narrowed, sizeof(narrowed));
+        } else {
+            *at = value;
+        }
+        break;
+    }
+}
+
+// Text of a fieldKindText field.
+QString FieldString(const gunConfig_s &config, uint8_t field);
+
+// Sets a fieldKindText field, cut at a character boundary if it doesn't fit; false if it was cut.
+bool FieldSetString(gunConfig_s &config, uint8_t field, const QString &text);
+
+// Whether a and b agree on field, as far as the gun is concerned.
+bool FieldEqual(const gunConfig_s &a, const gunConfig_s &b, uint8_t field);
+
+// Xm write that puts config's value of field on the gun, empty for fields that aren't written this way.
+QString FieldWrite(const gunConfig_s &config, uint8_t field);
+
+const char *const boolNames[8] = {
+    "Custom Pins",
+    "Rumble",
+    "Solenoid",
+    "Autofire",
+    "Simple Pause",
+    "Hold to Pause",
+    "Common Anode LED",
+    "Nunchuck"
+};
+
+const char *const settingNames[8] = {
+    "Rumble Intensity",
+    "Rumble Length",
+    "Solenoid Normal Interval",
+    "Solenoid Fast Interval",
+    "Solenoid Hold Length",
+    "Custom LED Count",
+    "Autofire Wait Factor",
+    "Hold to Pause Length"
+};
+
+const char *const profileFieldNames[profileFieldsCount] = {
+    "X Scale",
+    "Y Scale",
+    "X Center",
+    "Y Center",
+    "IR Sensitivity",
+    "Run Mode"
+};
+
+#endif // CONFIGFIELDS_H
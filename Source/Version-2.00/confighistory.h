@@ -0,0 +1,152 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CONFIGHISTORY_H
+#define CONFIGHISTORY_H
+
+#include <QElapsedTimer>
+#include <cstdint>
+
+// Max edits remembered; the oldest fall off once full.
+#define HISTORY_SIZE 1024
+// Repeat edits of one field closer together than this become a single undo step.
+#define HISTORY_COALESCE_MS 750
+
+// One change to a configFields_e.
+typedef struct configEdit_t {
+    int32_t from;
+    int32_t to;
+    // When it was last touched, for coalescing
+    int32_t when;
+    uint8_t field;
+    // Undone/redone together with the edit before it (e.g. an input bumped off a pin)
+    bool chained;
+} configEdit_s;
+
+// Undo/redo log of config edits, as a fixed ring of small deltas:
+// memory never grows and every operation is O(1) per edit touched.
+class ConfigHistory
+{
+public:
+    ConfigHistory() { clock.start(); }
+
+    void Clear() { head = 0; count = 0; cursor = 0; sealed = true; }
+
+    // Edits recorded between these are undone/redone as one step.
+    void BeginGroup() { grouping = true; groupStarted = false; }
+    void EndGroup() { grouping = false; }
+
+    void Record(uint8_t field, int32_t from, int32_t to)
+    {
+        if(from == to) {
+            return;
+        }
+        // Anything undone is gone once something new happens.
+        count = cursor;
+        int32_t now = clock.elapsed();
+        bool chained = grouping && groupStarted;
+        groupStarted = grouping;
+
+        if(!grouping && !sealed && cursor) {
+            configEdit_s &last = At(cursor - 1);
+            // Only lone edits merge, so a coalesced step never splits a group.
+            if(!last.chained && last.field == field && now - last.when < HISTORY_COALESCE_MS) {
+                last.to = to;
+                last.when = now;
+                if(last.from == last.to) {
+                    // Back where it started, nothing to undo anymore.
+                    count--;
+                    cursor--;
+                }
+                return;
+            }
+        }
+        sealed = false;
+
+        if(count == HISTORY_SIZE) {
+            // Drop the oldest step, including any edits chained to it.
+            do {
+                head = (head + 1) % HISTORY_SIZE;
+                count--;
+            } while(count && At(0).chained);
+        }
+        configEdit_s &edit = At(count);
+        edit.field = field;
+        edit.from = from;
+        edit.to = to;
+        edit.when = now;
+        edit.chained = chained;
+        count++;
+        cursor = count;
+    }
+
+    bool CanUndo() const { return cursor > 0; }
+    bool CanRedo() const { return cursor < count; }
+
+    // Steps back one edit (group), calling apply(field, value) newest first.
+    // Returns the field of the step's first edit, or -1 if there was nothing to undo.
+    template<typename Apply>
+    int Undo(Apply apply)
+    {
+        if(!cursor) {
+            return -1;
+        }
+        sealed = true;
+        const configEdit_s *edit;
+        do {
+            cursor--;
+            edit = &At(cursor);
+            apply(edit->field, edit->from);
+        } while(edit->chained && cursor);
+        return edit->field;
+    }
+
+    // Reapplies the next undone edit (group), oldest first.
+    template<typename Apply>
+    int Redo(Apply apply)
+    {
+        if(cursor == count) {
+            return -1;
+        }
+        sealed = true;
+        uint8_t first = At(cursor).field;
+        do {
+            apply(At(cursor).field, At(cursor).to);
+            cursor++;
+        } while(cursor < count && At(cursor).chained);
+        return first;
+    }
+
+private:
+    configEdit_s &At(uint16_t index) { return edits[(head + index) % HISTORY_SIZE]; }
+
+    configEdit_s edits[HISTORY_SIZE];
+    // Ring index of the oldest edit
+    uint16_t head = 0;
+    // Edits stored, including undone ones
+    uint16_t count = 0;
+    // Edits currently applied; everything from here to count can be redone
+    uint16_t cursor = 0;
+
+    // Set after undo/redo, so the next edit starts a fresh step instead of merging
+    bool sealed = true;
+    bool grouping = false;
+    bool groupStarted = false;
+    QElapsedTimer clock;
+};
+
+#endif // CONFIGHISTORY_H
@@ -20,14 +20,8 @@
 
 #include <QMainWindow>
 
-enum boardTypes_e {
-    nothing = 0,
-    rpipico,
-    adafruitItsyRP2040,
-    adafruitKB2040,
-    arduinoNanoRP2040,
-    generic = 255
-};
+// Number of mappable inputs, i.e. boardInputs_e above btnUnmapped
+#define INPUTS_COUNT 25
 
 enum boardInputs_e {
     btnReserved = -1,
@@ -81,25 +75,46 @@ enum settingsTypes_e {
     holdToPauseLength
 };
 
+// Firmware defaults for a freshly flashed gun, by boolTypes_e / settingsTypes_e
+const bool boolDefaults[8] = {
+    false, // customPins
+    true,  // rumble
+    true,  // solenoid
+    false, // autofire
+    false, // simplePause
+    false, // holdToPause
+    true,  // commonAnode
+    false  // nunChuck
+};
+
+const uint16_t settingsDefaults[8] = {
+    255,  // rumbleStrength
+    150,  // rumbleInterval
+    45,   // solenoidNormalInterval
+    30,   // solenoidFastInterval
+    500,  // solenoidHoldLength
+    1,    // customLEDcount
+    3,    // autofireWaitFactor
+    2500  // holdToPauseLength
+};
+
 enum pinTypes_e {
     pinNothing = 0,
     pinDigital,
     pinAnalog
 };
 
+struct boardDef_t;
+
 typedef struct boardInfo_t {
-    uint8_t type = nothing;
+    // Registry entry for the connected board, null until one has identified itself
+    const boardDef_t *def = nullptr;
     float versionNumber = 0;
     QString versionCodename;
     uint8_t selectedProfile;
     uint8_t previousProfile;
 } boardInfo_s;
 
-typedef struct tinyUSBtable_t {
-    QString tinyUSBid;
-    QString tinyUSBname;
-} tinyUSBtable_s;
-
 typedef struct profilesTable_t {
     uint16_t xScale;
     uint16_t yScale;
@@ -114,100 +129,4 @@ typedef struct boardLayout_t {
     uint8_t pinType;
 } boardLayout_s;
 
-const boardLayout_t rpipicoLayout[] = {
-    {btnGunA, pinDigital},     {btnGunB, pinDigital},
-    {btnGunC, pinDigital},     {btnStart, pinDigital},
-    {btnSelect, pinDigital},   {btnHome, pinDigital},
-    {btnGunUp, pinDigital},    {btnGunDown, pinDigital},
-    {btnGunLeft, pinDigital},  {btnGunRight, pinDigital},
-    {ledR, pinDigital},        {ledG, pinDigital},
-    {ledB, pinDigital},        {btnPump, pinDigital},
-    {btnPedal, pinDigital},    {btnTrigger, pinDigital},
-    {solenoidPin, pinDigital}, {rumblePin, pinDigital},
-    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
-    {btnReserved, pinNothing}, {btnReserved, pinNothing}, // SCL/SDA
-    {btnUnmapped, pinDigital}, {btnReserved, pinNothing}, // 23, 24, 25
-    {btnReserved, pinNothing}, {btnReserved, pinNothing}, // are unused/unexposed
-    {btnUnmapped, pinAnalog},  {btnUnmapped, pinAnalog},  // ADC pins
-    {btnUnmapped, pinAnalog},  {-2, pinNothing}           // ADC, padding
-};
-
-const boardLayout_t adafruitItsyRP2040Layout[] = {
-    {btnGunUp, pinDigital},    {btnGunDown, pinDigital},
-    {btnReserved, pinNothing}, {btnReserved, pinNothing},
-    {btnGunLeft, pinDigital},  {btnGunRight, pinDigital},
-    {btnTrigger, pinDigital},  {btnGunA, pinDigital},
-    {btnGunB, pinDigital},     {btnGunC, pinDigital},
-    {btnStart, pinDigital},    {btnSelect, pinDigital},
-    {btnPedal, pinDigital},    {btnReserved, pinNothing},
-    {btnReserved, pinNothing}, {btnReserved, pinNothing},
-    {btnReserved, pinNothing}, {btnReserved, pinNothing},
-    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
-    {btnUnmapped, pinDigital}, {btnReserved, pinNothing},
-    {btnReserved, pinNothing}, {btnReserved, pinNothing},
-    {rumblePin, pinDigital},   {solenoidPin, pinDigital},
-    {btnUnmapped, pinAnalog},  {btnUnmapped, pinAnalog},
-    {btnUnmapped, pinAnalog},  {btnUnmapped, pinAnalog}
-};
-
-const boardLayout_t adafruitKB2040Layout[] = {
-    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
-    {btnReserved, pinNothing}, {btnReserved, pinNothing},
-    {btnGunB, pinDigital},     {rumblePin, pinDigital},
-    {btnGunC, pinDigital},     {solenoidPin, pinDigital},
-    {btnSelect, pinDigital},   {btnStart, pinDigital},
-    {btnGunRight, pinDigital},
-
-    {btnReserved, pinNothing}, {btnReserved, pinNothing},
-    {btnReserved, pinNothing}, {btnReserved, pinNothing},
-    {btnReserved, pinNothing}, {btnReserved, pinNothing},
-    {btnReserved, pinNothing},
-
-    {btnGunUp, pinDigital},    {btnGunLeft, pinDigital},
-    {btnGunDown, pinDigital},
-
-    {btnReserved, pinNothing}, {btnReserved, pinNothing},
-    {btnReserved, pinNothing}, {btnReserved, pinNothing},
-    {btnReserved, pinNothing},
-
-    {tempPin, pinAnalog},      {btnHome, pinAnalog},
-    {btnTrigger, pinAnalog},   {btnGunA, pinAnalog}
-};
-
-const boardLayout_t arduinoNanoRP2040Layout[] = {
-    {btnTrigger, pinDigital},  {btnPedal, pinDigital},
-    {btnReserved, pinNothing}, {btnReserved, pinNothing},
-    {btnGunA, pinDigital},     {btnGunC, pinDigital},
-    {btnUnmapped, pinDigital}, {btnGunB, pinDigital},
-    {btnReserved, pinNothing}, {btnReserved, pinNothing},
-    {btnReserved, pinNothing}, {btnReserved, pinNothing},
-    {btnReserved, pinNothing}, {btnReserved, pinNothing},
-    {btnReserved, pinNothing}, {btnUnmapped, pinDigital},
-    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
-    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
-    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
-    {btnReserved, pinNothing}, {btnReserved, pinNothing},
-    {btnReserved, pinNothing}, {btnUnmapped, pinDigital},
-    {btnUnmapped, pinAnalog},  {btnUnmapped, pinAnalog},
-    {btnUnmapped, pinAnalog},  {btnUnmapped, pinAnalog}
-};
-
-const boardLayout_t genericLayout[] = {
-    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
-    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
-    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
-    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
-    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
-    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
-    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
-    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
-    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
-    {btnUnmapped, pinDigital}, {btnUnmapped, pinDigital},
-    {btnReserved, pinNothing}, {btnReserved, pinNothing}, // SCL/SDA
-    {btnUnmapped, pinDigital}, {btnReserved, pinNothing}, // 23, 24, 25
-    {btnReserved, pinNothing}, {btnReserved, pinNothing}, // are unused/unexposed
-    {btnUnmapped, pinAnalog},  {btnUnmapped, pinAnalog},  // ADC pins
-    {btnUnmapped, pinAnalog},  {-2, pinNothing}           // ADC, padding
-};
-
 #endif // CONSTANTS_H
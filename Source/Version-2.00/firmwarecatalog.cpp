@@ -0,0 +1,190 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "firmwarecatalog.h"
+#include "firmwarestore.h"
+#include "uf2image.h"
+#include "uf2map.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVersionNumber>
+#include <QtDebug>
+#include <algorithm>
+
+QString FirmwareCatalog::Key(const QString &board, const QString &version, uint8_t player)
+{
+    return QString("%1/%2/%3").arg(board, version).arg(player);
+}
+
+
+bool FirmwareCatalog::Fail(const QString &why)
+{
+    error = why;
+    return false;
+}
+
+
+void FirmwareCatalog::Insert(const firmwareEntry_s &entry)
+{
+    entries.insert(Key(entry.board, entry.version, entry.player), entry);
+    QStringList &list = versions[entry.board];
+    if(list.contains(entry.version)) {
+        return;
+    }
+    list.append(entry.version);
+    std::sort(list.begin(), list.end(), [](const QString &a, const QString &b) {
+        return QVersionNumber::fromString(a) > QVersionNumber::fromString(b);
+    });
+}
+
+
+int FirmwareCatalog::LoadDir(const QString &dir)
+{
+    QDir folder(dir);
+    int found = 0;
+    QFile file(folder.filePath(FIRMWARE_CATALOG_FILE));
+    if(file.open(QIODevice::ReadOnly)) {
+        const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+        if(root.value("version").toInt() != FIRMWARE_CATALOG_VERSION) {
+            qDebug() << "Skipping firmware catalog" << file.fileName() << "- unknown format";
+            return 0;
+        }
+        const QJsonArray list = root.value("images").toArray();
+        for(const QJsonValue &value : list) {
+            const QJsonObject object = value.toObject();
+            firmwareEntry_s entry;
+            entry.version = object.value("version").toString();
+            entry.board = object.value("board").toString();
+            const int player = object.value("player").toInt();
+            entry.name = object.value("file").toString();
+            entry.size = object.contains("size") ? qint64(object.value("size").toDouble()) : -1;
+            entry.sha256 = object.value("sha256").toString().toLatin1().toLower();
+            if(entry.version.isEmpty() || entry.board.isEmpty() || player < 1 || player > 4 || entry.name.isEmpty()) {
+                qDebug() << "Skipping incomplete firmware catalog entry in" << file.fileName() << object;
+                continue;
+            }
+            entry.player = player - 1;
+            entry.file = folder.filePath(entry.name);
+            Insert(entry);
+            found++;
+        }
+        return found;
+    }
+
+    // No catalog: whatever's loose in the folder, as it always was.
+    for(uint8_t player = 0; player < 4; player++) {
+        firmwareEntry_s entry;
+        entry.player = player;
+        entry.name = QString("Player%1.uf2").arg(player + 1);
+        if(!folder.exists(entry.name)) {
+            continue;
+        }
+        entry.file = folder.filePath(entry.name);
+        Insert(entry);
+        found++;
+    }
+    return found;
+}
+
+
+const firmwareEntry_s *FirmwareCatalog::Find(const QString &board, const QString &version, uint8_t player) const
+{
+    auto it = entries.constFind(Key(board, version, player));
+    if(it == entries.constEnd()) {
+        it = entries.constFind(Key(QString(), version, player));
+    }
+    return it == entries.constEnd() ? nullptr : &it.value();
+}
+
+
+QStringList FirmwareCatalog::Versions(const QString &board) const
+{
+    QStringList list = versions.value(board);
+    if(!board.isEmpty() && versions.contains(QString())) {
+        list.append(QString());
+    }
+    return list;
+}
+
+
+bool FirmwareCatalog::Matches(const firmwareEntry_s &entry, Uf2Map &map)
+{
+    if(!map.Open(entry.file) || !map.Validate()) {
+        return Fail(map.Error());
+    }
+    if(entry.size >= 0 && map.Size() != entry.size) {
+        return Fail(QString("%1 is %2 bytes, but the catalog says %3; it's damaged or not the listed file.")
+                    .arg(entry.file).arg(map.Size()).arg(entry.size));
+    }
+    if(!entry.sha256.isEmpty() && map.Hash().toHex() != entry.sha256) {
+        return Fail(QString("%1 doesn't match its SHA-256 in the catalog; it's damaged or not the listed file.").arg(entry.file));
+    }
+    return true;
+}
+
+
+bool FirmwareCatalog::Verify(const firmwareEntry_s &entry)
+{
+    error.clear();
+    if(QFile::exists(entry.file)) {
+        Uf2Map map;
+        return Matches(entry, map);
+    }
+    if(store && store->Contains(entry.name)) {
+        return true;
+    }
+    return Fail(QString("%1 is listed in the firmware catalog, but it's missing.").arg(entry.file));
+}
+
+
+bool FirmwareCatalog::Image(const firmwareEntry_s &entry, Uf2Image &image)
+{
+    error.clear();
+    if(QFile::exists(entry.file)) {
+        // Checked where it lies, then copied once.
+        Uf2Map map;
+        if(!Matches(entry, map)) {
+            return false;
+        }
+        return image.Load(map) || Fail(image.Error());
+    } else if(store && store->Contains(entry.name)) {
+        const QString temp = QDir::temp().filePath(QString("pigs-%1.uf2").arg(store->Hash(entry.name)));
+        if(!store->Extract(entry.name, temp)) {
+            return Fail(store->Error());
+        }
+        const bool loaded = image.Load(temp);
+        QFile::remove(temp);
+        if(!loaded) {
+            return Fail(image.Error());
+        }
+    } else {
+        return Fail(QString("%1 is listed in the firmware catalog, but it's missing.").arg(entry.file));
+    }
+
+    if(entry.size >= 0 && image.Data().size() != entry.size) {
+        return Fail(QString("%1 is %2 bytes, but the catalog says %3; it's damaged or not the listed file.")
+                    .arg(entry.file).arg(image.Data().size()).arg(entry.size));
+    }
+    if(!entry.sha256.isEmpty() && QCryptographicHash::hash(image.Data(), QCryptographicHash::Sha256).toHex() != entry.sha256) {
+        return Fail(QString("%1 doesn't match its SHA-256 in the catalog; it's damaged or not the listed file.").arg(entry.file));
+    }
+    return true;
+}
@@ -0,0 +1,106 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FIRMWARECATALOG_H
+#define FIRMWARECATALOG_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+class FirmwareStore;
+class Uf2Image;
+class Uf2Map;
+
+// Manifest in a firmware folder listing what's in it
+#define FIRMWARE_CATALOG_FILE "catalog.json"
+#define FIRMWARE_CATALOG_VERSION 1
+// Board the firmware is for when there's no gun to ask; every shipped build so far is a Pico one
+#define FIRMWARE_DEFAULT_BOARD "rpipico"
+
+// One flashable image.
+typedef struct firmwareEntry_t {
+    QString version;
+    // Board id, as the firmware reports it in "XP"; empty for loose files that don't say
+    QString board;
+    // Player slot, 0-3
+    uint8_t player;
+    // Absolute path of the UF2
+    QString file;
+    // file relative to its folder, which is also its name in the firmware store
+    QString name;
+    // What the image should come out as; -1/empty if unknown (loose files)
+    qint64 size = -1;
+    QByteArray sha256;
+} firmwareEntry_s;
+
+// Every firmware image on hand, indexed by (board, version, player), read from the
+// catalog.json manifest of each firmware folder so listing them never opens an image.
+//
+// catalog.json:
+//   { "version": 1, "images": [ { "version", "board", "player" (1-4),
+//       "file" (relative to the folder), "size", "sha256" }, ... ] }
+//
+// Folders without a catalog still work the old way: loose PlayerN.uf2 files become
+// unversioned entries for any board.
+class FirmwareCatalog
+{
+public:
+    // Adds the images in dir, replacing entries already loaded for the same key.
+    // Returns how many were found.
+    int LoadDir(const QString &dir);
+
+    // Images missing from their folder are rebuilt from store, by their catalog file name.
+    void SetStore(FirmwareStore *store) { this->store = store; }
+
+    // Image for board/version/player, falling back to an unversioned loose file; nullptr if there's none.
+    const firmwareEntry_s *Find(const QString &board, const QString &version, uint8_t player) const;
+
+    // Versions available for board, newest first; an empty string stands for loose files.
+    QStringList Versions(const QString &board) const;
+
+    int Count() const { return entries.size(); }
+    QList<firmwareEntry_s> Entries() const { return entries.values(); }
+
+    // Loads entry's image and checks it's the exact file the catalog lists.
+    bool Image(const firmwareEntry_s &entry, Uf2Image &image);
+
+    // Checks entry without loading it: a file is mapped and checked in place. Images only
+    // in the store are taken on its word (it verifies on extract).
+    bool Verify(const firmwareEntry_s &entry);
+
+    const QString &Error() const { return error; }
+
+private:
+    static QString Key(const QString &board, const QString &version, uint8_t player);
+
+    bool Fail(const QString &why);
+
+    // Checks an entry's file, mapped into map, is the one listed.
+    bool Matches(const firmwareEntry_s &entry, Uf2Map &map);
+
+    void Insert(const firmwareEntry_s &entry);
+
+    QHash<QString, firmwareEntry_s> entries;
+    // board -> versions, kept sorted newest first
+    QHash<QString, QStringList> versions;
+    FirmwareStore *store = nullptr;
+    QString error;
+};
+
+#endif // FIRMWARECATALOG_H
@@ -0,0 +1,418 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "firmwarestore.h"
+#include "uf2image.h"
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QPair>
+#include <QSaveFile>
+#include <QtEndian>
+#include <QtDebug>
+#include <cstddef>
+#include <cstring>
+
+#define DELTA_OP_COPY 1
+#define DELTA_OP_ADD 2
+// Bytes of a whole object copied per read when it's streamed out as is
+#define FIRMWARE_COPY_CHUNK (16 * UF2_BLOCK_SIZE)
+
+static void PutU32(QByteArray &out, quint32 value)
+{
+    char bytes[4];
+    qToLittleEndian<quint32>(value, bytes);
+    out.append(bytes, 4);
+}
+
+
+static bool GetU32(QIODevice &in, quint32 &value)
+{
+    char bytes[4];
+    if(in.read(bytes, 4) != 4) {
+        return false;
+    }
+    value = qFromLittleEndian<quint32>(bytes);
+    return true;
+}
+
+
+// Concatenated block payloads of image, or empty if its blocks aren't all plain full-page
+// flash writes with the same flags and zero padding, i.e. if regenerating its headers wouldn't give back the same file.
+static QByteArray Payloads(const Uf2Image &image)
+{
+    QByteArray payloads;
+    payloads.reserve(image.BlockCount() * UF2_PAYLOAD_SIZE);
+    const uf2Block_s first = image.Block(0);
+    for(uint32_t i = 0; i < image.BlockCount(); i++) {
+        const uf2Block_s block = image.Block(i);
+        if(block.flags != first.flags || block.familyID != first.familyID || block.flags & UF2_FLAG_NOT_MAIN_FLASH) {
+            return QByteArray();
+        }
+        for(uint32_t p = UF2_PAYLOAD_SIZE; p < sizeof(block.data); p++) {
+            if(block.data[p]) {
+                return QByteArray();
+            }
+        }
+        payloads.append(reinterpret_cast<const char*>(block.data), UF2_PAYLOAD_SIZE);
+    }
+    return payloads;
+}
+
+
+bool FirmwareStore::Fail(const QString &why)
+{
+    error = why;
+    qDebug() << "Firmware store:" << why;
+    return false;
+}
+
+
+QString FirmwareStore::ObjectPath(const QString &hash) const
+{
+    return root + "/objects/" + hash;
+}
+
+
+bool FirmwareStore::Open(const QString &root)
+{
+    this->root = root;
+    base.clear();
+    images.clear();
+    error.clear();
+    if(!QDir().mkpath(root + "/objects")) {
+        return Fail(QString("Couldn't create %1.").arg(root));
+    }
+    QFile file(root + "/index.json");
+    if(!file.open(QIODevice::ReadOnly)) {
+        return true;
+    }
+    const QJsonObject index = QJsonDocument::fromJson(file.readAll()).object();
+    if(index.value("version").toInt() != FIRMWARE_STORE_VERSION) {
+        return true;
+    }
+    base = index.value("base").toString();
+    const QJsonObject list = index.value("images").toObject();
+    for(auto it = list.constBegin(); it != list.constEnd(); ++it) {
+        images.insert(it.key(), it.value().toString());
+    }
+    return true;
+}
+
+
+bool FirmwareStore::Save() const
+{
+    QJsonObject list;
+    for(auto it = images.constBegin(); it != images.constEnd(); ++it) {
+        list[it.key()] = it.value();
+    }
+    QJsonObject index;
+    index["version"] = FIRMWARE_STORE_VERSION;
+    index["base"] = base;
+    index["images"] = list;
+
+    QSaveFile file(root + "/index.json");
+    if(!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(index).toJson());
+    return file.commit();
+}
+
+
+QByteArray FirmwareStore::Delta(const Uf2Image &image) const
+{
+    Uf2Image baseImage;
+    if(!baseImage.Load(ObjectPath(base))) {
+        return QByteArray();
+    }
+    const QByteArray source = Payloads(baseImage);
+    const QByteArray target = Payloads(image);
+    if(source.isEmpty() || target.isEmpty()) {
+        return QByteArray();
+    }
+
+    QByteArray delta(FIRMWARE_DELTA_MAGIC);
+    delta.append(QByteArray::fromHex(base.toLatin1()));
+    const uf2Block_s first = image.Block(0);
+    PutU32(delta, first.flags);
+    PutU32(delta, first.familyID);
+    PutU32(delta, image.BlockCount());
+    // Runs of consecutive pages, which for a normal build is just the one
+    QList<QPair<quint32, quint32>> runs;
+    for(uint32_t i = 0; i < image.BlockCount(); i++) {
+        const quint32 address = image.Block(i).targetAddr;
+        if(!runs.isEmpty() && runs.last().first + runs.last().second * UF2_PAYLOAD_SIZE == address) {
+            runs.last().second++;
+        } else {
+            runs.append({address, 1});
+        }
+    }
+    PutU32(delta, runs.size());
+    for(const QPair<quint32, quint32> &run : runs) {
+        PutU32(delta, run.first);
+        PutU32(delta, run.second);
+    }
+
+    // First place each window of the base shows up
+    QHash<QByteArray, quint32> windows;
+    windows.reserve(source.size());
+    for(int i = 0; i + FIRMWARE_DELTA_MATCH <= source.size(); i++) {
+        const QByteArray window = QByteArray::fromRawData(source.constData() + i, FIRMWARE_DELTA_MATCH);
+        if(!windows.contains(window)) {
+            windows.insert(window, i);
+        }
+    }
+
+    QByteArray pending;
+    auto flushPending = [&]() {
+        if(!pending.isEmpty()) {
+            delta.append(char(DELTA_OP_ADD));
+            PutU32(delta, pending.size());
+            delta.append(pending);
+            pending.clear();
+        }
+    };
+    int i = 0;
+    while(i < target.size()) {
+        auto match = windows.constEnd();
+        if(i + FIRMWARE_DELTA_MATCH <= target.size()) {
+            match = windows.constFind(QByteArray::fromRawData(target.constData() + i, FIRMWARE_DELTA_MATCH));
+        }
+        if(match == windows.constEnd()) {
+            pending.append(target[i++]);
+            continue;
+        }
+        const int from = match.value();
+        int length = FIRMWARE_DELTA_MATCH;
+        while(i + length < target.size() && from + length < source.size() && target[i + length] == source[from + length]) {
+            length++;
+        }
+        flushPending();
+        delta.append(char(DELTA_OP_COPY));
+        PutU32(delta, from);
+        PutU32(delta, length);
+        i += length;
+    }
+    flushPending();
+
+    if(delta.size() >= image.Data().size()) {
+        return QByteArray();
+    }
+    return delta;
+}
+
+
+bool FirmwareStore::Add(const QString &name, const QString &path)
+{
+    Uf2Image image;
+    if(!image.Load(path)) {
+        return Fail(image.Error());
+    }
+    const QString hash = QString::fromLatin1(QCryptographicHash::hash(image.Data(), QCryptographicHash::Sha256).toHex());
+
+    if(!QFile::exists(ObjectPath(hash))) {
+        const bool haveBase = !base.isEmpty() && QFile::exists(ObjectPath(base));
+        QByteArray object = haveBase ? Delta(image) : QByteArray();
+        for(int attempt = 0; attempt < 2; attempt++) {
+            if(object.isEmpty()) {
+                object = image.Data();
+            }
+            QSaveFile file(ObjectPath(hash));
+            if(!file.open(QIODevice::WriteOnly) || file.write(object) != object.size() || !file.commit()) {
+                return Fail(QString("Couldn't write %1: %2").arg(file.fileName(), file.errorString()));
+            }
+            // A delta that doesn't rebuild the image exactly is no use; keep the whole thing instead.
+            QBuffer check;
+            check.open(QIODevice::WriteOnly);
+            QCryptographicHash sha(QCryptographicHash::Sha256);
+            if(WriteObject(hash, check, sha) && sha.result().toHex() == hash.toLatin1()) {
+                break;
+            }
+            if(object == image.Data()) {
+                QFile::remove(ObjectPath(hash));
+                return Fail(QString("%1 didn't read back correctly.").arg(ObjectPath(hash)));
+            }
+            object.clear();
+        }
+        if(!haveBase) {
+            base = hash;
+        }
+        qDebug() << "Firmware store:" << name << "stored in" << QFileInfo(ObjectPath(hash)).size() << "bytes of" << image.Data().size();
+    }
+    images.insert(name, hash);
+    if(!Save()) {
+        return Fail(QString("Couldn't write %1/index.json.").arg(root));
+    }
+    return true;
+}
+
+
+bool FirmwareStore::WriteObject(const QString &hash, QIODevice &out, QCryptographicHash &sha)
+{
+    QFile object(ObjectPath(hash));
+    if(!object.open(QIODevice::ReadOnly)) {
+        return Fail(QString("Object %1 is missing from the store.").arg(hash));
+    }
+    if(object.peek(strlen(FIRMWARE_DELTA_MAGIC)) != FIRMWARE_DELTA_MAGIC) {
+        while(!object.atEnd()) {
+            const QByteArray chunk = object.read(FIRMWARE_COPY_CHUNK);
+            if(chunk.isEmpty() || out.write(chunk) != chunk.size()) {
+                return Fail(QString("Couldn't copy object %1.").arg(hash));
+            }
+            sha.addData(chunk);
+        }
+        return true;
+    }
+
+    object.skip(strlen(FIRMWARE_DELTA_MAGIC));
+    const QByteArray baseHash = object.read(32).toHex();
+    quint32 flags, familyID, count, runCount;
+    if(baseHash.size() != 64 || !GetU32(object, flags) || !GetU32(object, familyID) || !GetU32(object, count) || !GetU32(object, runCount)) {
+        return Fail(QString("Object %1 is truncated.").arg(hash));
+    }
+    QList<QPair<quint32, quint32>> runs;
+    quint32 runBlocks = 0;
+    for(quint32 r = 0; r < runCount; r++) {
+        quint32 address, blocks;
+        if(!GetU32(object, address) || !GetU32(object, blocks) || !blocks) {
+            return Fail(QString("Object %1 is truncated.").arg(hash));
+        }
+        runs.append({address, blocks});
+        runBlocks += blocks;
+    }
+    if(runBlocks != count) {
+        return Fail(QString("Object %1 is damaged.").arg(hash));
+    }
+    QFile baseObject(ObjectPath(QString::fromLatin1(baseHash)));
+    if(!baseObject.open(QIODevice::ReadOnly) || baseObject.peek(strlen(FIRMWARE_DELTA_MAGIC)) == FIRMWARE_DELTA_MAGIC) {
+        return Fail(QString("Base %1 of object %2 is missing from the store.").arg(QString::fromLatin1(baseHash), hash));
+    }
+    const quint64 baseBytes = quint64(baseObject.size() / UF2_BLOCK_SIZE) * UF2_PAYLOAD_SIZE;
+
+    // The only image data ever held: the block being built, and one page of input.
+    char block[UF2_BLOCK_SIZE] = {};
+    char page[UF2_PAYLOAD_SIZE];
+    quint32 blockNo = 0;
+    quint32 fill = 0;
+    int run = 0;
+    quint32 runDone = 0;
+    auto put = [&](const char *bytes, quint32 length) {
+        while(length) {
+            if(blockNo >= count) {
+                return false;
+            }
+            const quint32 n = qMin<quint32>(length, UF2_PAYLOAD_SIZE - fill);
+            memcpy(block + offsetof(uf2Block_s, data) + fill, bytes, n);
+            fill += n;
+            bytes += n;
+            length -= n;
+            if(fill < UF2_PAYLOAD_SIZE) {
+                continue;
+            }
+            const quint32 address = runs[run].first + runDone * UF2_PAYLOAD_SIZE;
+            if(++runDone == runs[run].second) {
+                run++;
+                runDone = 0;
+            }
+            qToLittleEndian<quint32>(UF2_MAGIC_START0, block + offsetof(uf2Block_s, magicStart0));
+            qToLittleEndian<quint32>(UF2_MAGIC_START1, block + offsetof(uf2Block_s, magicStart1));
+            qToLittleEndian<quint32>(flags, block + offsetof(uf2Block_s, flags));
+            qToLittleEndian<quint32>(address, block + offsetof(uf2Block_s, targetAddr));
+            qToLittleEndian<quint32>(UF2_PAYLOAD_SIZE, block + offsetof(uf2Block_s, payloadSize));
+            qToLittleEndian<quint32>(blockNo, block + offsetof(uf2Block_s, blockNo));
+            qToLittleEndian<quint32>(count, block + offsetof(uf2Block_s, numBlocks));
+            qToLittleEndian<quint32>(familyID, block + offsetof(uf2Block_s, familyID));
+            qToLittleEndian<quint32>(UF2_MAGIC_END, block + offsetof(uf2Block_s, magicEnd));
+            if(out.write(block, UF2_BLOCK_SIZE) != UF2_BLOCK_SIZE) {
+                return false;
+            }
+            sha.addData(QByteArray::fromRawData(block, UF2_BLOCK_SIZE));
+            blockNo++;
+            fill = 0;
+        }
+        return true;
+    };
+
+    char op;
+    while(object.getChar(&op)) {
+        quint32 from = 0, length;
+        if((op == DELTA_OP_COPY && !GetU32(object, from)) || !GetU32(object, length)) {
+            return Fail(QString("Object %1 is truncated.").arg(hash));
+        }
+        if(op == DELTA_OP_COPY) {
+            if(quint64(from) + length > baseBytes) {
+                return Fail(QString("Object %1 is damaged.").arg(hash));
+            }
+            while(length) {
+                const quint32 within = from % UF2_PAYLOAD_SIZE;
+                const quint32 n = qMin<quint32>(length, UF2_PAYLOAD_SIZE - within);
+                if(!baseObject.seek(qint64(from / UF2_PAYLOAD_SIZE) * UF2_BLOCK_SIZE + offsetof(uf2Block_s, data) + within)
+                   || baseObject.read(page, n) != qint64(n) || !put(page, n)) {
+                    return Fail(QString("Couldn't rebuild object %1.").arg(hash));
+                }
+                from += n;
+                length -= n;
+            }
+        } else if(op == DELTA_OP_ADD) {
+            while(length) {
+                const quint32 n = qMin<quint32>(length, UF2_PAYLOAD_SIZE);
+                if(object.read(page, n) != qint64(n) || !put(page, n)) {
+                    return Fail(QString("Couldn't rebuild object %1.").arg(hash));
+                }
+                length -= n;
+            }
+        } else {
+            return Fail(QString("Object %1 is damaged.").arg(hash));
+        }
+    }
+    if(blockNo != count || fill) {
+        return Fail(QString("Object %1 is truncated.").arg(hash));
+    }
+    return true;
+}
+
+
+bool FirmwareStore::Extract(const QString &name, const QString &path)
+{
+    const QString hash = images.value(name);
+    if(hash.isEmpty()) {
+        return Fail(QString("There's no %1 in the firmware store.").arg(name));
+    }
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly)) {
+        return Fail(QString("Couldn't write %1: %2").arg(path, file.errorString()));
+    }
+    QCryptographicHash sha(QCryptographicHash::Sha256);
+    if(!WriteObject(hash, file, sha)) {
+        file.cancelWriting();
+        return false;
+    }
+    if(sha.result().toHex() != hash.toLatin1()) {
+        file.cancelWriting();
+        return Fail(QString("%1 came out of the store damaged (SHA-256 mismatch); add it again.").arg(name));
+    }
+    if(!file.commit()) {
+        return Fail(QString("Couldn't write %1: %2").arg(path, file.errorString()));
+    }
+    return true;
+}
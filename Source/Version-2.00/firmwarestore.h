@@ -0,0 +1,83 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FIRMWARESTORE_H
+#define FIRMWARESTORE_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+class QCryptographicHash;
+class QIODevice;
+class Uf2Image;
+
+// Bumped whenever the index or object formats change, so an old store gets rebuilt.
+#define FIRMWARE_STORE_VERSION 1
+// First bytes of a delta object; anything else in objects/ is a whole UF2
+#define FIRMWARE_DELTA_MAGIC "PIGSDLT1"
+// Shortest run of base bytes worth a copy instead of carrying the bytes themselves
+#define FIRMWARE_DELTA_MATCH 16
+
+// Local store of firmware images that keeps near-duplicate releases cheap:
+// the first image added is kept whole as the base, every later one as a binary delta against it.
+// Objects are named by the SHA-256 of the image they rebuild, so an image
+// added twice is stored once, and anything read back is checked against its name.
+//
+// root/index.json   names ("1.75/Player2.uf2") -> object hash, and which object is the base
+// root/objects/<sha256>   whole UF2 (the base), or a delta:
+//     magic, base hash (32 bytes), then little-endian u32s: block flags, family id,
+//     block count, address run count, runs of { first address, blocks }; then ops till the end:
+//     1 = copy { base payload offset, length }, 2 = add { length, bytes }
+//   Ops rebuild the concatenated 256-byte block payloads; the UF2 block headers around
+//   them are regenerated from the flags, family id and address runs.
+class FirmwareStore
+{
+public:
+    // Opens (or starts) the store in root; an unreadable index just starts out empty.
+    bool Open(const QString &root);
+
+    // Validates the UF2 at path and stores it under name, replacing whatever name had.
+    bool Add(const QString &name, const QString &path);
+
+    // Rebuilds name into path, a few blocks at a time, and only keeps the file if its
+    // SHA-256 matches; a damaged store never leaves a bad image behind.
+    bool Extract(const QString &name, const QString &path);
+
+    QStringList Names() const { return images.keys(); }
+    bool Contains(const QString &name) const { return images.contains(name); }
+    // SHA-256 (hex) of the image stored under name, empty if there's none
+    QString Hash(const QString &name) const { return images.value(name); }
+
+    const QString &Error() const { return error; }
+
+private:
+    bool Fail(const QString &why);
+    bool Save() const;
+    QString ObjectPath(const QString &hash) const;
+    // Encodes image as a delta against the base, or returns empty if it isn't worth it.
+    QByteArray Delta(const Uf2Image &image) const;
+    // Streams object hash out to out, feeding sha everything written.
+    bool WriteObject(const QString &hash, QIODevice &out, QCryptographicHash &sha);
+
+    QString root;
+    QString base;
+    QHash<QString, QString> images;
+    QString error;
+};
+
+#endif // FIRMWARESTORE_H
@@ -17,66 +17,92 @@
 
 #include "guiwindow.h"
 #include "constants.h"
+#include "batchflashdialog.h"
+#include "boardregistry.h"
+#include "bootloaderwatcher.h"
+#include "boardview.h"
+#include "configcache.h"
+#include "configfields.h"
+#include "confighistory.h"
+#include "firmwarecatalog.h"
+#include "firmwarestore.h"
+#include "imageoverlay.h"
+#include "pinmap.h"
+#include "pinsolver.h"
+#include "profilelibrary.h"
+#include "stagedconfigs.h"
+#include "uf2flasher.h"
+#include "uf2image.h"
 #include "qlineedit.h"
 #include "ui_guiwindow.h"
 #include "ui_about.h"
 #include <QGraphicsScene>
 #include <QMessageBox>
 #include <QRadioButton>
-#include <QSvgRenderer>
-#include <QSvgWidget>
 #include <QSerialPortInfo>
 #include <QtDebug>
 #include <QProgressBar>
+#include <QElapsedTimer>
+#include <QGridLayout>
+#include <QGroupBox>
+#include <QInputDialog>
+#include <QListWidget>
+#include <QAction>
+#include <QTimer>
+#include <QCheckBox>
+#include <QSpinBox>
+#include <QPushButton>
 #include <QProcess>
+#include <QStandardPaths>
 #include <QStorageInfo>
+#include <QFile>
 #include <QThread>
 #include <QCoreApplication>
 #include <QMessageBox>
 
 
+// Every board we know the layout of, keyed by firmware board id
+BoardRegistry boardRegistry;
+
 // Currently loaded board object
 boardInfo_s board;
 
-// Currently loaded board's TinyUSB identifier info
-tinyUSBtable_s tinyUSBtable;
-// TinyUSB ident, as loaded from the board
-tinyUSBtable_s tinyUSBtable_orig;
-
-// Current calibration profiles
-QVector<profilesTable_s> profilesTable(4);
-// Calibration profiles, as loaded from the board
-QVector<profilesTable_s> profilesTable_orig(4);
-
-// Indexed array map of the current physical layout of the board.
-// Key = pin number, Value = pin function
-// Values: -2 = N/A, -1 = reserved, 0 = available, unused
-QMap<uint8_t, int8_t> currentPins;
-
-#define INPUTS_COUNT 25
-// Map of what inputs are put where,
-// Key = button/output, Value = pin number occupying, if any.
-// Value of -1 means unmapped.
-// Key order based on boardInputs_e, minus 1
-// Map functions used in deduplication
-QMap<uint8_t, int8_t> inputsMap;
-// Inputs map, as loaded from the board
-QMap<uint8_t, int8_t> inputsMap_orig;
+// Last known config of every gun we've talked to
+ConfigCache configCache;
+
+// Saved calibration profiles, for more screens than the gun has slots
+ProfileLibrary profileLibrary;
+
+// Configs prepared offline, waiting for their guns to connect
+StagedConfigs stagedConfigs;
+
+// Firmware images available to flash, and the local store backing them
+FirmwareCatalog firmwareCatalog;
+FirmwareStore firmwareStore;
+
+// Current config, as edited in the UI. Its pins are what the pin editor shows:
+// the custom mapping when customPins is on, otherwise the board's default layout.
+gunConfig_s gunConfig;
+// Config as loaded from (or last saved to) the gun
+gunConfig_s gunConfig_orig;
+// What the current board's pins can host, for O(1) placement checks
+pinCaps_s pinCaps;
+
+// USB VID/PID the firmware for each player enumerates as
+const QPair<int, int> playerUsbIds[4] = {
+    {0x0321, 0x0420},
+    {0x0322, 0x0421},
+    {0x0323, 0x0422},
+    {0x0324, 0x0423}
+};
 
 // ^^^-----Typedefs up there:----^^^
 //
 // vvv---UI Objects down here:---vvv
 
-// Guess I'll have to do the dynamic layout spawning/destroying stuff to make things work.
-// How else do I hide things lol?
-// QVBoxLayout *PinsCenter;
-// QGridLayout *PinsCenterSub;
-// QGridLayout *PinsLeft;
-// QGridLayout *PinsRight;
-
+// Pin editor widgets, created once in the constructor and reused across boards.
 QComboBox *pinBoxes[30];
 QLabel *pinLabel[30];
-QWidget *padding[30];
 
 QRadioButton *selectedProfile[4];
 QLabel *xScale[4];
@@ -85,7 +111,6 @@ QLabel *xCenter[4];
 QLabel *yCenter[4];
 QComboBox *irSens[4];
 QComboBox *runMode[4];
-QSvgWidget *centerPic;
 
 QGraphicsScene *testScene;
 
@@ -118,15 +143,14 @@ void guiWindow::PortsSearch()
         return;
     }
 
-    QMap<QPair<int, int>, QString> piggieMap = {
-        {{0x0321, 0x0420}, "Piggie 1"},
-        {{0x0322, 0x0421}, "Piggie 2"},
-        {{0x0323, 0x0422}, "Piggie 3"},
-        {{0x0324, 0x0423}, "Piggie 4"}
-    };
+    QMap<QPair<int, int>, QString> piggieMap;
+    for(uint8_t i = 0; i < 4; i++) {
+        piggieMap.insert(playerUsbIds[i], QString("Piggie %1").arg(i + 1));
+    }
 
     bool lightgunFound = false;
-    for (const QSerialPortInfo &portInfo : serialFoundList) {
+    for (int portIndex = 0; portIndex < serialFoundList.size(); portIndex++) {
+        const QSerialPortInfo &portInfo = serialFoundList[portIndex];
         QPair<int, int> vidPid = {portInfo.vendorIdentifier(), portInfo.productIdentifier()};
 
         // Check if the VID/PID matches known devices
@@ -138,7 +162,8 @@ void guiWindow::PortsSearch()
             cleanedLocation.remove("\\\\.\\"); // Remove unwanted prefixes
 
             // Add entry to the dropdown: "Friendly Name (Cleaned Location)"
-            ui->comPortSelector->addItem(displayName + " (" + cleanedLocation + ")");
+            // Only some ports make it into the list, so remember which one this entry is.
+            ui->comPortSelector->addItem(displayName + " (" + cleanedLocation + ")", portIndex);
             qDebug() << "Added to dropdown:" << displayName << "@" << cleanedLocation;
 
             lightgunFound = true;
@@ -159,6 +184,23 @@ guiWindow::guiWindow(QWidget *parent)
     , ui(new Ui::guiWindow)
 {
     ui->setupUi(this);
+    imageOverlay = new ImageOverlay(this);
+
+    // Extra board definitions: shipped next to the executable, then per-user (which win on clashes).
+    boardRegistry.LoadDir(QCoreApplication::applicationDirPath() + "/boards");
+    boardRegistry.LoadDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/boards");
+    configCache.Load(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/configcache.json");
+    profileLibrary.Load(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/profiles.json");
+    stagedConfigs.Load(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/staged.json");
+    // Firmware: shipped next to the executable, then per-user downloads (which win on clashes).
+    firmwareStore.Open(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/firmware");
+    firmwareCatalog.SetStore(&firmwareStore);
+    firmwareCatalog.LoadDir(QCoreApplication::applicationDirPath() + "/uf2");
+    firmwareCatalog.LoadDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/uf2");
+    fwVersionBox = new QComboBox();
+    fwVersionBox->setToolTip("Firmware version to flash, from the firmware catalog.");
+    ui->gridLayout_4->addWidget(fwVersionBox, 10, 2, 1, 2);
+
     on_pbRefreshDev_clicked();
 
 #ifdef Q_OS_UNIX
@@ -179,31 +221,122 @@ guiWindow::guiWindow(QWidget *parent)
 
     connect(&serialPort, &QSerialPort::readyRead, this, &guiWindow::serialPort_readyRead);
 
-    // just to be sure, init the inputsMap hashes
-    for(uint8_t i = 0; i < INPUTS_COUNT; i++) {
-        inputsMap[i] = -1;
-        inputsMap_orig[i] = -1;
-    }
-
-    // sending all these children to die upon comPortSelector->on_currentIndexChanged
-    // (which gets fired immediately after ui->comPortSelector->addItems).
-    // PinsCenter = new QVBoxLayout();
-    // PinsCenterSub = new QGridLayout();
-    // PinsLeft = new QGridLayout();
-    // PinsRight = new QGridLayout();
-
-    // ui->PinsTopHalf->addLayout(PinsLeft);
-    // ui->PinsTopHalf->addLayout(PinsCenter);
-    // ui->PinsTopHalf->addLayout(PinsRight);
-
+    // just to be sure, init the configs
+    gunConfig.Clear();
+    gunConfig_orig.Clear();
+
+    // The pin editor is built once and kept for the whole session;
+    // switching boards only updates these widgets in place (see PinBoxesRefresh).
+    pinsTab = new QWidget();
+    QGridLayout *pinsGrid = new QGridLayout(pinsTab);
+    customPinsToggle = new QCheckBox("Custom pin mapping");
+    connect(customPinsToggle, &QCheckBox::stateChanged, this, &guiWindow::customPinsToggle_stateChanged);
+    pinsGrid->addWidget(customPinsToggle, 0, 0, 1, 2);
+    autoPinsBtn = new QPushButton("Auto-assign");
+    autoPinsBtn->setCheckable(true);
+    autoPinsBtn->setEnabled(false);
+    autoPinsBtn->setToolTip("Place every input on a pin that supports it, keeping the pins you've set yourself.\nWhile on, inputs bumped off a pin get moved somewhere else instead of unmapped.");
+    connect(autoPinsBtn, &QPushButton::toggled, this, &guiWindow::autoPinsBtn_toggled);
+    pinsGrid->addWidget(autoPinsBtn, 0, 3, 1, 2);
     for(uint8_t i = 0; i < 30; i++) {
         pinBoxes[i] = new QComboBox();
-        connect(pinBoxes[i], SIGNAL(activated(int)), this, SLOT(pinBoxes_activated(int)));
-        pinLabel[i] = new QLabel();
+        pinBoxes[i]->setSizePolicy(QSizePolicy::Fixed,QSizePolicy::Fixed);
+        // Bind the pin number here so the slot doesn't have to search for its sender.
+        connect(pinBoxes[i], QOverload<int>::of(&QComboBox::activated), this, [this, i](int index) {
+            pinBoxes_activated(i, index);
+        });
+        pinLabel[i] = new QLabel(QString("<GPIO%1>").arg(i));
+        pinLabel[i]->setEnabled(false);
         pinLabel[i]->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
-        padding[i] = new QWidget();
-        padding[i]->setMinimumHeight(25);
+        // GPIO0-14 down the left half, GPIO15-29 down the right, board picture in between.
+        pinsGrid->addWidget(pinLabel[i], i % 15 + 1, (i / 15) * 3);
+        pinsGrid->addWidget(pinBoxes[i], i % 15 + 1, (i / 15) * 3 + 1);
+        pinBoxesType[i] = 0xFF;
     }
+    boardView = new BoardView();
+    pinsGrid->addWidget(boardView, 1, 2, 15, 1);
+    pinsGrid->setColumnStretch(2, 1);
+    ui->tabWidget->insertTab(1, pinsTab, "Pin Mapping");
+
+    // Widgets that each edit one bool/tunable, by boolTypes_e / settingsTypes_e.
+    // Edits, refreshes and undo all go through these rather than per-widget slots.
+    boolWidgets[rumble] = ui->rumbleToggle;
+    boolWidgets[solenoid] = ui->solenoidToggle;
+    boolWidgets[autofire] = ui->autofireToggle;
+    boolWidgets[holdToPause] = ui->holdToPauseToggle;
+    settingWidgets[rumbleStrength] = ui->rumbleIntensityBox;
+    settingWidgets[rumbleInterval] = ui->rumbleLengthBox;
+    settingWidgets[solenoidNormalInterval] = ui->solenoidNormalIntervalBox;
+    settingWidgets[solenoidFastInterval] = ui->solenoidFastIntervalBox;
+    settingWidgets[solenoidHoldLength] = ui->solenoidHoldLengthBox;
+    settingWidgets[autofireWaitFactor] = ui->autofireWaitFactorBox;
+    settingWidgets[holdToPauseLength] = ui->holdToPauseLengthBox;
+    for(uint8_t i = 0; i < 8; i++) {
+        if(boolWidgets[i]) {
+            connect(boolWidgets[i], &QCheckBox::stateChanged, this, [this, i](int state) {
+                SetBool(i, state);
+            });
+        }
+        if(settingWidgets[i]) {
+            connect(settingWidgets[i], QOverload<int>::of(&QSpinBox::valueChanged), this, [this, i](int value) {
+                SetSetting(i, value);
+            });
+        }
+    }
+
+    livePreviewToggle = new QCheckBox("Live preview rumble && solenoid changes (unsaved until confirmed)");
+    livePreviewToggle->setToolTip("Sends rumble and solenoid tweaks to the gun as you make them, so you can feel them right away.\nUnconfirmed changes are reverted when this is turned off or the gun is disconnected.");
+    connect(livePreviewToggle, &QCheckBox::toggled, this, &guiWindow::livePreviewToggle_toggled);
+    ui->verticalLayout_7->addWidget(livePreviewToggle);
+    previewTimer = new QTimer(this);
+    previewTimer->setSingleShot(true);
+    previewTimer->setInterval(PREVIEW_INTERVAL_MS);
+    connect(previewTimer, &QTimer::timeout, this, &guiWindow::PreviewFlush);
+
+    offlineBtn = new QPushButton("Edit Offline...");
+    offlineBtn->setToolTip("Prepare a config for a gun that isn't plugged in.\nIt's queued and saved to the gun automatically the next time it connects.");
+    connect(offlineBtn, &QPushButton::clicked, this, &guiWindow::OfflineBegin);
+    ui->horizontalLayout_4->addWidget(offlineBtn);
+    stagedWatch = new QTimer(this);
+    stagedWatch->setInterval(STAGED_WATCH_MS);
+    connect(stagedWatch, &QTimer::timeout, this, &guiWindow::StagedWatch);
+    StagedWatchUpdate();
+
+    bootloaderWatcher = new BootloaderWatcher(this);
+    connect(bootloaderWatcher, &BootloaderWatcher::PortGone, this, &guiWindow::BootloaderPortGone);
+    connect(bootloaderWatcher, &BootloaderWatcher::ResetFailed, this, &guiWindow::BootloaderResetFailed);
+    connect(bootloaderWatcher, &BootloaderWatcher::Found, this, &guiWindow::BootloaderFound);
+    connect(bootloaderWatcher, &BootloaderWatcher::TimedOut, this, &guiWindow::BootloaderTimedOut);
+    flasher = new Uf2Flasher(this);
+    connect(flasher, &Uf2Flasher::Progress, this, &guiWindow::FlashProgress);
+    connect(flasher, &Uf2Flasher::Verifying, this, [this]() {
+        ui->statusBar->showMessage("Written, reading the flash back to check it...");
+    });
+    connect(flasher, &Uf2Flasher::Finished, this, &guiWindow::FlashFinished);
+    flashReconnect = new QTimer(this);
+    flashReconnect->setInterval(FLASH_RECONNECT_POLL_MS);
+    connect(flashReconnect, &QTimer::timeout, this, &guiWindow::FlashReconnect);
+    flashAllBtn = new QPushButton("Flash All Players");
+    flashAllBtn->setToolTip("Reboot every connected gun to its bootloader and flash each one with its current player's firmware, all at once.");
+    connect(flashAllBtn, &QPushButton::clicked, this, &guiWindow::FlashAll);
+    ui->gridLayout_4->addWidget(flashAllBtn, 12, 3);
+    updateBtn = new QPushButton("Update Connected Gun");
+    updateBtn->setToolTip("Flash the connected gun with the picked firmware, reconnect to it, and put back any settings the update changed.");
+    connect(updateBtn, &QPushButton::clicked, this, &guiWindow::UpdateBegin);
+    ui->gridLayout_4->addWidget(updateBtn, 12, 2);
+
+    QAction *undoAction = new QAction("Undo", this);
+    undoAction->setShortcut(QKeySequence::Undo);
+    connect(undoAction, &QAction::triggered, this, [this]() {
+        HistoryStep(false);
+    });
+    addAction(undoAction);
+    QAction *redoAction = new QAction("Redo", this);
+    redoAction->setShortcut(QKeySequence::Redo);
+    connect(redoAction, &QAction::triggered, this, [this]() {
+        HistoryStep(true);
+    });
+    addAction(redoAction);
 
     // These can actually stay, tho.
     for(uint8_t i = 0; i < 4; i++) {
@@ -236,6 +369,32 @@ guiWindow::guiWindow(QWidget *parent)
         ui->profilesArea->addWidget(runMode[i], i+1, 11, 1, 1);
     }
 
+    // Profile library, under the calibration buttons.
+    QGroupBox *libraryBox = new QGroupBox("Profile Library");
+    QGridLayout *libraryGrid = new QGridLayout(libraryBox);
+    librarySearch = new QLineEdit();
+    librarySearch->setPlaceholderText("Search by name or display");
+    librarySearch->setClearButtonEnabled(true);
+    connect(librarySearch, &QLineEdit::textChanged, this, &guiWindow::LibraryRefresh);
+    libraryGrid->addWidget(librarySearch, 0, 0, 1, 2);
+    libraryGunOnly = new QCheckBox("This gun only");
+    connect(libraryGunOnly, &QCheckBox::toggled, this, &guiWindow::LibraryRefresh);
+    libraryGrid->addWidget(libraryGunOnly, 0, 2);
+    libraryList = new QListWidget();
+    connect(libraryList, &QListWidget::itemDoubleClicked, this, &guiWindow::LibraryLoad);
+    libraryGrid->addWidget(libraryList, 1, 0, 1, 3);
+    QPushButton *librarySaveBtn = new QPushButton("Save Selected Profile...");
+    connect(librarySaveBtn, &QPushButton::clicked, this, &guiWindow::LibrarySave);
+    libraryGrid->addWidget(librarySaveBtn, 2, 0);
+    QPushButton *libraryLoadBtn = new QPushButton("Load Into Selected Profile");
+    connect(libraryLoadBtn, &QPushButton::clicked, this, &guiWindow::LibraryLoad);
+    libraryGrid->addWidget(libraryLoadBtn, 2, 1);
+    QPushButton *libraryDeleteBtn = new QPushButton("Delete");
+    connect(libraryDeleteBtn, &QPushButton::clicked, this, &guiWindow::LibraryDelete);
+    libraryGrid->addWidget(libraryDeleteBtn, 2, 2);
+    ui->gridLayout_3->addWidget(libraryBox, 3, 0, 1, 4);
+    LibraryRefresh();
+
     // Setup Test Mode screen colors
     testPointTLPen.setColor(Qt::green);
     testPointTRPen.setColor(Qt::green);
@@ -282,6 +441,7 @@ guiWindow::guiWindow(QWidget *parent)
 guiWindow::~guiWindow()
 {
     if(serialPort.isOpen()) {
+        PreviewRevert();
         statusBar()->showMessage("Sending undock request to board...");
         serialPort.write("XE");
         serialPort.waitForBytesWritten(2000);
@@ -294,85 +454,19 @@ guiWindow::~guiWindow()
 void guiWindow::on_ledSetupBtn_clicked()
 {
     serialPort.write("LED_SETUP_CMD"); // Command for LED setup (replace with your actual command)
-        QLabel *imageLabel = new QLabel(this); // Create QLabel to hold the image
-        QPixmap pixmap(":/images/setup/LED-Setup.png"); // Load the image for LED setup
-
-        // Scale the image to the size of the window or screen
-        pixmap = pixmap.scaled(this->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-        imageLabel->setPixmap(pixmap); // Set the scaled image to the label
-        imageLabel->setAlignment(Qt::AlignCenter); // Center the image in the label
-        imageLabel->setGeometry(0, 0, this->width(), this->height()); // Set label to cover the entire window
-
-        // Create the close button
-        QPushButton *closeButton = new QPushButton("Close", this);
-        closeButton->setGeometry(this->width() - 100, this->height() - 50, 80, 30); // Position the button in the bottom right corner
-        closeButton->setStyleSheet("font-size: 16px; background-color: red; color: white;"); // Optional styling
-
-        // Connect the close button click to close the image window
-        connect(closeButton, &QPushButton::clicked, [imageLabel, closeButton]() {
-            imageLabel->close(); // Close the image window
-            closeButton->close(); // Close the close button
-        });
-
-        imageLabel->show(); // Show the label containing the image
-        closeButton->show(); // Show the close button
-    }
+    imageOverlay->ShowImage(":/images/setup/LED-Setup.png");
+}
 
 void guiWindow::on_lgTipsBtn_clicked()
 {
     serialPort.write("LED_SETUP_CMD"); // Command for LED setup (replace with your actual command)
-        QLabel *imageLabel = new QLabel(this); // Create QLabel to hold the image
-        QPixmap pixmap(":/images/setup/LG-Tips.png"); // Load the image for LED setup
-
-        // Scale the image to the size of the window or screen
-        pixmap = pixmap.scaled(this->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-        imageLabel->setPixmap(pixmap); // Set the scaled image to the label
-        imageLabel->setAlignment(Qt::AlignCenter); // Center the image in the label
-        imageLabel->setGeometry(0, 0, this->width(), this->height()); // Set label to cover the entire window
-
-        // Create the close button
-        QPushButton *closeButton = new QPushButton("Close", this);
-        closeButton->setGeometry(this->width() - 100, this->height() - 50, 80, 30); // Position the button in the bottom right corner
-        closeButton->setStyleSheet("font-size: 16px; background-color: red; color: white;"); // Optional styling
-
-        // Connect the close button click to close the image window
-        connect(closeButton, &QPushButton::clicked, [imageLabel, closeButton]() {
-            imageLabel->close(); // Close the image window
-            closeButton->close(); // Close the close button
-        });
-
-        imageLabel->show(); // Show the label containing the image
-        closeButton->show(); // Show the close button
-    }
+    imageOverlay->ShowImage(":/images/setup/LG-Tips.png");
+}
 void guiWindow::on_lgSetupBtn_clicked()
 {
     serialPort.write("LG_SETUP_CMD"); // Command for LG setup (replace with your actual command)
-        QLabel *imageLabel = new QLabel(this); // Create QLabel to hold the image
-        QPixmap pixmap(":/images/setup/LG-Setup.png"); // Load the image for LG setup
-
-        // Scale the image to the size of the window or screen
-        pixmap = pixmap.scaled(this->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-        imageLabel->setPixmap(pixmap); // Set the scaled image to the label
-        imageLabel->setAlignment(Qt::AlignCenter); // Center the image in the label
-        imageLabel->setGeometry(0, 0, this->width(), this->height()); // Set label to cover the entire window
-
-        // Create the close button
-        QPushButton *closeButton = new QPushButton("Close", this);
-        closeButton->setGeometry(this->width() - 100, this->height() - 50, 80, 30); // Position the button in the bottom right corner
-        closeButton->setStyleSheet("font-size: 16px; background-color: red; color: white;"); // Optional styling
-
-        // Connect the close button click to close the image window
-        connect(closeButton, &QPushButton::clicked, [imageLabel, closeButton]() {
-            imageLabel->close(); // Close the image window
-            closeButton->close(); // Close the close button
-        });
-
-        imageLabel->show(); // Show the label containing the image
-        closeButton->show(); // Show the close button
-    }
+    imageOverlay->ShowImage(":/images/setup/LG-Setup.png");
+}
 
 
 void guiWindow::PopupWindow(QString errorTitle, QString errorMessage, QString windowTitle, int errorType)
@@ -405,107 +499,89 @@ void guiWindow::PopupWindow(QString errorTitle, QString errorMessage, QString wi
 }
 
 // TODO: Copy loaded values to use for comparison to determine state of save button.
-void guiWindow::SerialLoad()
+// Reads the calibration profile in slot off the gun, into config.
+bool guiWindow::ProfileRead(uint8_t slot, gunConfig_s &config)
+{
+    serialPort.write(QString("XlP%1").arg(slot).toLocal8Bit());
+    serialPort.waitForBytesWritten(2000);
+    if(!serialPort.waitForReadyRead(2000)) {
+        return false;
+    }
+    for(uint8_t i = 0; i < profileFieldsCount; i++) {
+        FieldSet(config, fieldProfile + slot * profileFieldsCount + i, serialPort.readLine().trimmed().toInt());
+    }
+    return true;
+}
+
+
+void guiWindow::TinyUSBRead(gunConfig_s &config)
+{
+    serialPort.write("Xln");
+    serialPort.waitForReadyRead(1000);
+    QString buffer = serialPort.readLine();
+    if(buffer.trimmed() == "SERIALREADERR01") {
+        FieldSetString(config, fieldTinyUSBname, "");
+    } else if(!FieldSetString(config, fieldTinyUSBname, buffer.trimmed())) {
+        // Only shown cut; it's never written back unless it's changed here.
+        qDebug() << "TinyUSB name" << buffer.trimmed() << "is longer than" << TINYUSB_NAME_SIZE - 1 << "bytes, showing it cut short.";
+    }
+    serialPort.write("Xli");
+    serialPort.waitForReadyRead(1000);
+    buffer = serialPort.readLine();
+    FieldSetString(config, fieldTinyUSBid, buffer.trimmed());
+}
+
+
+// Reads the gun's booleans, pins and tunables into config.
+// Each reply comes in configSchema order, so every value lands through FieldSet.
+bool guiWindow::BlocksRead(gunConfig_s &config)
 {
-    serialActive = true;
     serialPort.write("Xlb");
     if(serialPort.waitForBytesWritten(2000)) {
         if(serialPort.waitForReadyRead(2000)) {
             // booleans
             QString buffer;
-            for(uint8_t i = 1; i < sizeof(boolSettings); i++) {
+            for(uint8_t field = fieldBool + 1; field < fieldSetting; field++) {
                 buffer = serialPort.readLine();
                 buffer = buffer.trimmed();
-                boolSettings[i] = buffer.toInt();
-                boolSettings_orig[i] = boolSettings[i];
+                FieldSet(config, field, buffer.toInt());
             }
             // pins
             serialPort.write("Xlp");
             serialPort.waitForReadyRead(1000);
             buffer = serialPort.readLine();
             buffer = buffer.trimmed();
-            boolSettings[customPins] = buffer.toInt(); // remember to change this BACK, teehee
-            boolSettings_orig[customPins] = boolSettings[customPins];
-            if(boolSettings[customPins]) {
-                for(uint8_t i = 0; i < INPUTS_COUNT; i++) {
-                    buffer = serialPort.readLine();
-                    inputsMap_orig[i] = buffer.toInt();
-                    // For some reason, QTSerial drops output shortly after this.
-                    // So we send a ping to refill the buffer.
-                    if(i == 14) {
-                        serialPort.write(".");
-                        serialPort.waitForReadyRead(1000);
-                    }
+            FieldSet(config, fieldBool + customPins, buffer.toInt()); // remember to change this BACK, teehee
+            config.pins.Clear();
+            for(uint8_t i = 0; i < INPUTS_COUNT; i++) {
+                buffer = serialPort.readLine();
+                // TODO: fix this in the firmware. (it sends pins even when customPins is off)
+                if(config.bools[customPins]) {
+                    FieldSet(config, fieldInputPin + i, buffer.toInt());
                 }
-                inputsMap = inputsMap_orig;
-            } else {
-                // TODO: fix this in the firmware.
-                for(uint8_t i = 0; i < INPUTS_COUNT; i++) {
-                    buffer = serialPort.readLine(); // nomfing
-                    inputsMap[i] = -1;
-                    inputsMap_orig[i] = -1;
-                    if(i == 14) {
-                        serialPort.write(".");
-                        serialPort.waitForReadyRead(1000);
-                    }
+                // For some reason, QTSerial drops output shortly after this.
+                // So we send a ping to refill the buffer.
+                if(i == 14) {
+                    serialPort.write(".");
+                    serialPort.waitForReadyRead(1000);
                 }
             }
             buffer = serialPort.readLine();
             buffer = buffer.trimmed();
             if(buffer != "-127") {
                 qDebug() << "Padding bit not detected!";
-                return;
+                return false;
             }
             // settings
             serialPort.write("Xls");
             serialPort.waitForBytesWritten(2000);
             serialPort.waitForReadyRead(2000);
-            for(uint8_t i = 0; i < 8; i++) {
-                buffer = serialPort.readLine();
-                buffer = buffer.trimmed();
-                settingsTable[i] = buffer.toInt();
-                settingsTable_orig[i] = settingsTable[i];
-            }
-            // profiles
-            for(uint8_t i = 0; i < 4; i++) {
-                QString genString = QString("XlP%1").arg(i);
-                serialPort.write(genString.toLocal8Bit());
-                serialPort.waitForBytesWritten(2000);
-                serialPort.waitForReadyRead(2000);
-                buffer = serialPort.readLine();
-                buffer = buffer.trimmed();
-                xScale[i]->setText(buffer);
-                profilesTable[i].xScale = buffer.toInt();
-                profilesTable_orig[i].xScale = profilesTable[i].xScale;
-                buffer = serialPort.readLine();
-                buffer = buffer.trimmed();
-                yScale[i]->setText(buffer);
-                profilesTable[i].yScale = buffer.toInt();
-                profilesTable_orig[i].yScale = profilesTable[i].yScale;
-                buffer = serialPort.readLine();
-                buffer = buffer.trimmed();
-                xCenter[i]->setText(buffer);
-                profilesTable[i].xCenter = buffer.toInt();
-                profilesTable_orig[i].xCenter = profilesTable[i].xCenter;
-                buffer = serialPort.readLine();
-                buffer = buffer.trimmed();
-                yCenter[i]->setText(buffer);
-                profilesTable[i].yCenter = buffer.toInt();
-                profilesTable_orig[i].yCenter = profilesTable[i].yCenter;
+            for(uint8_t field = fieldSetting; field < fieldInputPin; field++) {
                 buffer = serialPort.readLine();
                 buffer = buffer.trimmed();
-                profilesTable[i].irSensitivity = buffer.toInt();
-                profilesTable_orig[i].irSensitivity = profilesTable[i].irSensitivity;
-                irSens[i]->setCurrentIndex(profilesTable[i].irSensitivity);
-                irSensOldIndex[i] = profilesTable[i].irSensitivity;
-                buffer = serialPort.readLine();
-                buffer = buffer.trimmed();
-                profilesTable[i].runMode = buffer.toInt();
-                profilesTable_orig[i].runMode = profilesTable[i].runMode;
-                runMode[i]->setCurrentIndex(profilesTable[i].runMode);
-                runModeOldIndex[i] = profilesTable[i].runMode;
+                FieldSet(config, field, buffer.toInt());
             }
-            serialActive = false;
+            return true;
         } else {
             PopupWindow("Data hasn't arrived!", "Device was detected, but settings request wasn't received in time!\nThis can happen if the app was closed in the middle of an operation.\n\nTry selecting the device again.", "Oops!", 4);
             //qDebug() << "Didn't receive any data in time!";
@@ -513,12 +589,66 @@ void guiWindow::SerialLoad()
     } else {
         qDebug() << "Couldn't send any data in time! Does the port even exist???";
     }
+    return false;
+}
+
+
+// Reads the gun's booleans, pins, tunables and profiles into config (everything but the TinyUSB ident).
+bool guiWindow::SerialLoad(gunConfig_s &config)
+{
+    serialActive = true;
+    bool loaded = BlocksRead(config);
+    for(uint8_t i = 0; i < 4 && loaded; i++) {
+        loaded = ProfileRead(i, config);
+        if(!loaded) {
+            qDebug() << "Profile" << i << "didn't arrive!";
+        }
+    }
+    serialActive = false;
+    return loaded;
+}
+
+
+// Takes config as what's on the gun: sets both the current and _orig config, and the profile widgets.
+void guiWindow::ConfigApply(const gunConfig_s &config)
+{
+    memcpy(&gunConfig, &config, sizeof(gunConfig_s));
+    memcpy(&gunConfig_orig, &config, sizeof(gunConfig_s));
+    for(uint8_t i = 0; i < 4; i++) {
+        xScale[i]->setText(QString::number(gunConfig.profiles[i].xScale));
+        yScale[i]->setText(QString::number(gunConfig.profiles[i].yScale));
+        xCenter[i]->setText(QString::number(gunConfig.profiles[i].xCenter));
+        yCenter[i]->setText(QString::number(gunConfig.profiles[i].yCenter));
+        irSens[i]->setCurrentIndex(gunConfig.profiles[i].irSensitivity);
+        irSensOldIndex[i] = gunConfig.profiles[i].irSensitivity;
+        runMode[i]->setCurrentIndex(gunConfig.profiles[i].runMode);
+        runModeOldIndex[i] = gunConfig.profiles[i].runMode;
+    }
+}
+
+
+// Firmware build a cache entry belongs to.
+static QString CacheFirmware()
+{
+    return QString("%1 %2").arg(board.versionNumber).arg(board.versionCodename);
+}
+
+
+// Remembers the gun's config as of the last load/save for the next time it connects.
+void guiWindow::CacheStore()
+{
+    configCacheEntry_s entry;
+    entry.firmware = CacheFirmware();
+    entry.boardId = board.def ? board.def->id : "";
+    entry.config = gunConfig_orig;
+    configCache.Store(cacheKey, entry);
 }
 
-// Bool returns success (false if failed)
-// TODO: copy TinyUSB values to a backup for comparison to determine availability of save btn functionality
+
 bool guiWindow::SerialInit(int portNum)
 {
+    cacheKey.clear();
+    configFresh = false;
     serialPort.setPort(serialFoundList[portNum]);
     serialPort.setBaudRate(QSerialPort::Baud9600);
     if(serialPort.open(QIODevice::ReadWrite)) {
@@ -541,17 +671,8 @@ bool guiWindow::SerialInit(int portNum)
                     qDebug() << "Version codename:" << board.versionCodename;
                     buffer = serialPort.readLine();
                     buffer = buffer.trimmed();
-                    if(buffer == "rpipico") {
-                        board.type = rpipico;
-                    } else if(buffer == "adafruitItsyRP2040") {
-                        board.type = adafruitItsyRP2040;
-                    } else if(buffer == "adafruitKB2040") {
-                        board.type = adafruitKB2040;
-                    } else if(buffer == "arduinoNanoRP2040") {
-                        board.type = arduinoNanoRP2040;
-                    } else {
-                        board.type = generic;
-                    }
+                    // unknown ids get the generic LG2040 board
+                    board.def = boardRegistry.Find(buffer);
                     //qDebug() << "Selected profile number:" << buffer;
                     buffer = serialPort.readLine();
                     buffer = buffer.trimmed();
@@ -559,21 +680,31 @@ bool guiWindow::SerialInit(int portNum)
                     board.previousProfile = board.selectedProfile;
                     selectedProfile[board.selectedProfile]->setChecked(true);
                     //qDebug() << "Board type:" << buffer;
-                    serialPort.write("Xln");
-                    serialPort.waitForReadyRead(1000);
-                    buffer = serialPort.readLine();
-                    if(buffer.trimmed() == "SERIALREADERR01") {
-                        tinyUSBtable.tinyUSBname = "";
+                    gunConfig_s loaded;
+                    loaded.Clear();
+                    // The USB serial (the RP2040's flash id) costs no round trip to get;
+                    // boards without one are told apart by their TinyUSB id instead.
+                    QString serialNumber = serialFoundList[portNum].serialNumber();
+                    if(!serialNumber.isEmpty()) {
+                        cacheKey = "usb:" + serialNumber;
                     } else {
-                        tinyUSBtable.tinyUSBname = buffer.trimmed();
+                        TinyUSBRead(loaded);
+                        QString tinyUSBid = FieldString(loaded, fieldTinyUSBid);
+                        cacheKey = tinyUSBid.isEmpty() ? "" : "tinyusb:" + tinyUSBid;
                     }
-                    tinyUSBtable_orig.tinyUSBname = tinyUSBtable.tinyUSBname;
-                    serialPort.write("Xli");
-                    serialPort.waitForReadyRead(1000);
-                    buffer = serialPort.readLine();
-                    tinyUSBtable.tinyUSBid = buffer.trimmed();
-                    tinyUSBtable_orig.tinyUSBid = tinyUSBtable.tinyUSBid;
-                    SerialLoad();
+                    // Always a full read: nothing the gun answers proves an unchanged config,
+                    // and commits write every profile slot, so none of it can come from the cache.
+                    if(!serialNumber.isEmpty()) {
+                        TinyUSBRead(loaded);
+                    }
+                    if(!SerialLoad(loaded)) {
+                        // Don't leave the last gun's config up under this one's key.
+                        cacheKey.clear();
+                        return false;
+                    }
+                    ConfigApply(loaded);
+                    CacheStore();
+                    configFresh = true;
                     return true;
                 // } else {
                     // qDebug() << "Port did not respond with expected response!";
@@ -597,129 +728,131 @@ bool guiWindow::SerialInit(int portNum)
 }
 
 
+// Physical layout of the current board, falling back to the generic RP2040 layout.
+const boardLayout_t *BoardLayout()
+{
+    return (board.def ? board.def : boardRegistry.Generic())->layout;
+}
+
+
 void guiWindow::BoxesUpdate()
+{
+    if(gunConfig.bools[customPins]) {
+        gunConfig.pins = gunConfig_orig.pins;
+    } else {
+        gunConfig.pins.LoadLayout(BoardLayout());
+    }
+    pinsLocked = 0;
+    for(uint8_t i = 0; i < 30; i++) {
+        pinBoxes[i]->setEnabled(gunConfig.bools[customPins]);
+    }
+    BoxesSync();
+}
+
+
+// Shows gunConfig.pins in the pin editor.
+void guiWindow::BoxesSync()
 {
     for(uint8_t i = 0; i < 30; i++) {
-        pinBoxes[i]->setCurrentIndex(btnUnmapped);
-        pinBoxesOldIndex[i] = btnUnmapped;
-    }
-    if(boolSettings[customPins]) {
-        currentPins.clear();
-        for(uint8_t i = 0; i < 30; i++) {
-            pinBoxes[i]->setEnabled(true);
-            currentPins[i] = btnUnmapped;
-        }
-        inputsMap = inputsMap_orig;
+        pinBoxes[i]->setCurrentIndex(gunConfig.pins.pinInput[i] > btnUnmapped ? gunConfig.pins.pinInput[i] : btnUnmapped);
+    }
+    boardView->SetMapping(gunConfig.pins);
+}
+
+
+// Re-places the wanted inputs around the pins the user has set (pinsLocked),
+// preferring the pins in hint, then updates the editor.
+// Returns the inputs that didn't fit anywhere.
+uint32_t guiWindow::PinsSolve(uint32_t wanted, const pinMap_s &hint)
+{
+    QElapsedTimer solveTimer;
+    solveTimer.start();
+
+    pinConstraints_s constraints;
+    constraints.wanted = wanted;
+    constraints.lockedPins = pinsLocked;
+    constraints.pinned = gunConfig.pins;
+    constraints.hint = hint;
+    uint32_t unplaced = SolvePins(pinCaps, constraints, gunConfig.pins);
+    qDebug() << "Pins solved in" << solveTimer.nsecsElapsed() / 1000 << "us";
+
+    BoxesSync();
+    if(unplaced) {
+        QStringList names;
         for(uint8_t i = 0; i < INPUTS_COUNT; i++) {
-            if(inputsMap.value(i) >= 0) {
-                currentPins[inputsMap.value(i)] = i+1;
-                pinBoxes[inputsMap.value(i)]->setCurrentIndex(currentPins[inputsMap.value(i)]);
-                pinBoxesOldIndex[inputsMap.value(i)] = currentPins[inputsMap.value(i)];
-            }
-        }
-        return;
-    } else {
-        switch(board.type) {
-        case rpipico:
-        {
-            for(uint8_t i = 0; i < 30; i++) {
-                currentPins[i] = rpipicoLayout[i].pinAssignment;
-                pinBoxes[i]->setCurrentIndex(currentPins[i]);
-                pinBoxesOldIndex[i] = currentPins[i];
-                pinBoxes[i]->setEnabled(false);
+            if(unplaced & (1u << i)) {
+                names.append(valuesNameList[i+1]);
             }
-            return;
-            break;
-        }
-        case adafruitItsyRP2040:
-        {
-            for(uint8_t i = 0; i < 30; i++) {
-                currentPins[i] = adafruitItsyRP2040Layout[i].pinAssignment;
-                pinBoxes[i]->setCurrentIndex(currentPins[i]);
-                pinBoxesOldIndex[i] = currentPins[i];
-                pinBoxes[i]->setEnabled(false);
-            }
-            return;
-            break;
         }
-        case adafruitKB2040:
-        {
-            for(uint8_t i = 0; i < 30; i++) {
-                currentPins[i] = adafruitKB2040Layout[i].pinAssignment;
-                pinBoxes[i]->setCurrentIndex(currentPins[i]);
-                pinBoxesOldIndex[i] = currentPins[i];
-                pinBoxes[i]->setEnabled(false);
-            }
-            return;
-            break;
+        statusBar()->showMessage(QString("No pins left for: %1").arg(names.join(", ")), 5000);
+    }
+    return unplaced;
+}
+
+
+// Brings the pooled pin editor in line with the current board.
+// Combo contents are only rebuilt for pins whose type actually changed since the last board,
+// and the whole pass runs with repaints suspended so Qt relayouts once at the end.
+void guiWindow::PinBoxesRefresh()
+{
+    QElapsedTimer refreshTimer;
+    refreshTimer.start();
+
+    const boardLayout_t *layout = BoardLayout();
+    pinCaps.Load(layout);
+    boardView->SetBoard(board.def ? board.def : boardRegistry.Generic());
+    pinsTab->setUpdatesEnabled(false);
+    for(uint8_t i = 0; i < 30; i++) {
+        if(layout[i].pinType == pinBoxesType[i]) {
+            continue;
         }
-        case arduinoNanoRP2040:
-        {
-            for(uint8_t i = 0; i < 30; i++) {
-                currentPins[i] = arduinoNanoRP2040Layout[i].pinAssignment;
-                pinBoxes[i]->setCurrentIndex(currentPins[i]);
-                pinBoxesOldIndex[i] = currentPins[i];
-                pinBoxes[i]->setEnabled(false);
+        pinBoxes[i]->clear();
+        if(layout[i].pinType != pinNothing) {
+            pinBoxes[i]->addItems(valuesNameList);
+            if(layout[i].pinType == pinDigital) {
+                pinBoxes[i]->removeItem(25);
+                pinBoxes[i]->removeItem(24);
+                // replace "Temp Sensor" with a separator
+                // then remove the presumably bumped up temp sensor index.
+                pinBoxes[i]->insertSeparator(16);
+                pinBoxes[i]->removeItem(17);
             }
-            return;
-            break;
-        }
         }
+        // Reserved/unexposed pins have nothing to edit.
+        pinBoxes[i]->setVisible(layout[i].pinType != pinNothing);
+        pinLabel[i]->setVisible(layout[i].pinType != pinNothing);
+        pinBoxesType[i] = layout[i].pinType;
     }
+    BoxesUpdate();
+    pinsTab->setUpdatesEnabled(true);
+
+    qDebug() << "Pin editor refreshed in" << refreshTimer.nsecsElapsed() / 1000 << "us";
 }
 
 
+// Full recheck of every field against what was loaded from the gun.
+// Only needed when the loaded side changes (load/save); edits go through the Set* functions.
 void guiWindow::DiffUpdate()
 {
-    settingsDiff = 0;
-    if(boolSettings_orig[customPins] != boolSettings[customPins]) {
-        //settingsDiff++;
-    }
-    if(boolSettings[customPins]) {
-        if(inputsMap_orig != inputsMap) {
-            settingsDiff++;
-        }
-    }
-    for(uint8_t i = 1; i < sizeof(boolSettings); i++) {
-        if(boolSettings_orig[i] != boolSettings[i]) {
-            settingsDiff++;
-        }
-    }
-    for(uint8_t i = 0; i < sizeof(settingsTable) / 2; i++) {
-        if(settingsTable_orig[i] != settingsTable[i]) {
-            settingsDiff++;
-        }
-    }
-    if(tinyUSBtable_orig.tinyUSBid != tinyUSBtable.tinyUSBid) {
-        settingsDiff++;
-    }
-    if(tinyUSBtable_orig.tinyUSBname != tinyUSBtable.tinyUSBname) {
-        settingsDiff++;
-    }
-    if(board.selectedProfile != board.previousProfile) {
-        settingsDiff++;
-    }
-    for(uint8_t i = 0; i < 4; i++) {
-        if(profilesTable_orig[i].xScale != profilesTable[i].xScale) {
-            settingsDiff++;
-        }
-        if(profilesTable_orig[i].yScale != profilesTable[i].yScale) {
-            settingsDiff++;
-        }
-        if(profilesTable_orig[i].xCenter != profilesTable[i].xCenter) {
-            settingsDiff++;
-        }
-        if(profilesTable_orig[i].yCenter != profilesTable[i].yCenter) {
-            settingsDiff++;
-        }
-        if(profilesTable_orig[i].irSensitivity != profilesTable[i].irSensitivity) {
-            settingsDiff++;
-        }
-        if(profilesTable_orig[i].runMode != profilesTable[i].runMode) {
-            settingsDiff++;
+    // Same bytes can't differ anywhere, so the per-field walk is only needed otherwise.
+    if(!memcmp(&gunConfig, &gunConfig_orig, sizeof(gunConfig_s)) && board.selectedProfile == board.previousProfile) {
+        dirtyFields.reset();
+    } else {
+        for(uint8_t i = 0; i < fieldsCount; i++) {
+            dirtyFields[i] = FieldDiffers(i);
         }
     }
-    if(settingsDiff) {
+    ConfirmButtonUpdate();
+}
+
+
+void guiWindow::ConfirmButtonUpdate()
+{
+    if(!offlineKey.isEmpty()) {
+        // The whole config gets queued, so there's always something to send.
+        ui->confirmButton->setText(QString("Click To Queue Settings For %1").arg(offlineKey));
+        ui->confirmButton->setEnabled(true);
+    } else if(dirtyFields.any()) {
         ui->confirmButton->setText("Click To Save & Send Settings To LightGun");
         ui->confirmButton->setEnabled(true);
     } else {
@@ -729,222 +862,723 @@ void guiWindow::DiffUpdate()
 }
 
 
-void guiWindow::SyncSettings()
+// Current (or as-loaded, if orig) value of a configFields_e.
+// The TinyUSB strings aren't numbers and always read as 0 here.
+int32_t guiWindow::FieldValue(uint8_t field, bool orig) const
 {
-    for(uint8_t i = 0; i < sizeof(boolSettings); i++) {
-        boolSettings_orig[i] = boolSettings[i];
-    }
-    if(boolSettings_orig[customPins]) {
-        inputsMap_orig = inputsMap;
-    } else {
-        for(uint8_t i = 0; i < INPUTS_COUNT; i++)
-            inputsMap_orig[i] = -1;
-    }
-    for(uint8_t i = 0; i < sizeof(settingsTable) / 2; i++) {
-        settingsTable_orig[i] = settingsTable[i];
-    }
-    tinyUSBtable_orig.tinyUSBid = tinyUSBtable.tinyUSBid;
-    tinyUSBtable_orig.tinyUSBname = tinyUSBtable.tinyUSBname;
-    board.previousProfile = board.selectedProfile;
-    for(uint8_t i = 0; i < 4; i++) {
-        profilesTable_orig[i].irSensitivity = profilesTable[i].irSensitivity;
-        profilesTable_orig[i].runMode = profilesTable[i].runMode;
+    if(field == fieldSelectedProfile) {
+        return orig ? board.previousProfile : board.selectedProfile;
     }
+    return FieldGet(orig ? gunConfig_orig : gunConfig, field);
 }
 
 
-QString PrettifyName()
+bool guiWindow::FieldDiffers(uint8_t field) const
 {
-    QString name;
-    // if(!tinyUSBtable.tinyUSBname.isEmpty()) {
-    //     name = tinyUSBtable.tinyUSBname;
-    // } else {
-    //     name = "Unnamed Device";
-    // }
-    switch(board.type) {
-    case nothing:
-        name = "";
-        break;
-    case rpipico:
-        name = name + "Raspberry Pi Pico";
-        break;
-    case adafruitItsyRP2040:
-        name = name + "Adafruit ItsyBitsy RP2040";
-        break;
-    case adafruitKB2040:
-        name = name + "Adafruit KB2040";
-        break;
-    case arduinoNanoRP2040:
-        name = name + "Arduino Nano RP2040 Connect";
-        break;
-    case generic:
-        name = name + "LG2040";
-        break;
+    if(field == fieldSelectedProfile) {
+        return board.previousProfile != board.selectedProfile;
+    } else if(configSchema[field].kind == fieldKindPin) {
+        // The mapping only gets sent (and so only matters) with custom pins on.
+        return gunConfig.bools[customPins] && FieldStored(gunConfig_orig, field) != FieldValue(field);
     }
-    return name;
+    return !FieldEqual(gunConfig_orig, gunConfig, field);
 }
 
 
-void guiWindow::on_confirmButton_clicked()
+// O(1) dirty bit update; the save button is only touched when "anything to save" flips.
+void guiWindow::FieldDirty(uint8_t field, bool dirty)
 {
-    QMessageBox messageBox;
-    messageBox.setText("Are these settings okay?");
-    messageBox.setInformativeText("These settings will be committed to your lightgun. Is that okay?");
-    messageBox.setWindowTitle("Commit Confirmation");
-    messageBox.setIcon(QMessageBox::Information);
-    messageBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
-    messageBox.setDefaultButton(QMessageBox::Yes);
-    int value = messageBox.exec();
-    if(value == QMessageBox::Yes) {
-        if(serialPort.isOpen()) {
-            serialActive = true;
-            // send a signal so the gun pauses its test outputs for the save op.
-            serialPort.write("Xm");
-            serialPort.waitForBytesWritten(1000);
-
-            QProgressBar *statusProgressBar = new QProgressBar();
-            ui->statusBar->addPermanentWidget(statusProgressBar);
-            // ui->tabWidget->setEnabled(false);
-            ui->comPortSelector->setEnabled(false);
-            ui->confirmButton->setEnabled(false);
+    bool wasDirty = dirtyFields.any();
+    dirtyFields[field] = dirty;
+    if(dirtyFields.any() != wasDirty) {
+        ConfirmButtonUpdate();
+    }
+}
 
-            QStringList serialQueue;
-            for(uint8_t i = 1; i < sizeof(boolSettings); i++) {
-                QString genString = QString("Xm.0.%1.%2").arg(i-1).arg(boolSettings[i]);
-                serialQueue.append(genString);
-            }
 
-            if(boolSettings[customPins]) {
-                serialQueue.append("Xm.1.0.1");
-                for(uint8_t i = 0; i < INPUTS_COUNT; i++) {
-                    QString genString = QString("Xm.1.%1.%2").arg(i+1).arg(inputsMap.value(i));
-                    serialQueue.append(genString);
-                }
-            } else {
-                serialQueue.append("Xm.1.0.0");
-            }
+void guiWindow::SetBool(uint8_t index, bool value)
+{
+    FieldEdited(fieldBool + index, gunConfig.bools[index], value);
+    gunConfig.bools[index] = value;
+    FieldDirty(fieldBool + index, gunConfig_orig.bools[index] != value);
+    if(index == customPins) {
+        PinsDirtyRecheck();
+    }
+}
 
-            for(uint8_t i = 0; i < sizeof(settingsTable) / 2; i++) {
-                QString genString = QString("Xm.2.%1.%2").arg(i).arg(settingsTable[i]);
-                serialQueue.append(genString);
-            }
 
-            serialQueue.append(QString("Xm.3.0.%1").arg(tinyUSBtable.tinyUSBid));
-            if(!tinyUSBtable.tinyUSBname.isEmpty()) {
-                serialQueue.append(QString("Xm.3.1.%1").arg(tinyUSBtable.tinyUSBname));
-            }
-            for(uint8_t i = 0; i < 4; i++) {
-                serialQueue.append(QString("Xm.P.i.%1.%2").arg(i).arg(profilesTable[i].irSensitivity));
-                serialQueue.append(QString("Xm.P.r.%1.%2").arg(i).arg(profilesTable[i].runMode));
-            }
-            serialQueue.append("XS");
+void guiWindow::SetSetting(uint8_t index, uint16_t value)
+{
+    FieldEdited(fieldSetting + index, gunConfig.settings[index], value);
+    gunConfig.settings[index] = value;
+    FieldDirty(fieldSetting + index, gunConfig_orig.settings[index] != value);
+    // Nothing to stream when it's what the gun already runs, e.g. widgets refreshed from a freshly loaded gun;
+    // unless it was previewed, when going back to the saved value has to be sent too.
+    if(livePreviewToggle->isChecked() && (PREVIEW_SETTINGS & (1 << index)) &&
+       (value != gunConfig_orig.settings[index] || (previewApplied & (1 << index)))) {
+        PreviewQueue(1 << index);
+    }
+}
 
-            statusProgressBar->setRange(0, serialQueue.length()-1);
-            bool success = true;
 
-            // throw out whatever's in the buffer if there's anything there.
-            while(!serialPort.atEnd()) {
-                serialPort.readLine();
-            }
+// Marks tunables (bit = settingsTypes_e) to be streamed to the gun.
+// Sends are batched on a timer, and only the newest value of each goes out,
+// so dragging a spinbox costs at most one command per setting per interval.
+void guiWindow::PreviewQueue(uint8_t settings)
+{
+    previewPending |= settings;
+    if(!previewTimer->isActive()) {
+        previewTimer->start();
+    }
+}
 
-            for(uint8_t i = 0; i < serialQueue.length(); i++) {
-                serialPort.write(serialQueue[i].toLocal8Bit());
-                serialPort.waitForBytesWritten(2000);
-                if(serialPort.waitForReadyRead(2000)) {
-                    QString buffer = serialPort.readLine();
-                    if(buffer.contains("OK:") || buffer.contains("NOENT:")) {
-                        statusProgressBar->setValue(statusProgressBar->value() + 1);
-                    } else if(i == serialQueue.length() - 1 && buffer.contains("Saving preferences...")) {
-                        buffer = serialPort.readLine();
-                        if(buffer.contains("Settings saved to")) {
-                            success = true;
-                            // because there's probably some leftover bytes that might congest things:
-                            while(!serialPort.atEnd()) {
-                                serialPort.readLine();
-                            }
-                        } else {
-                            qDebug() << "Sent save command, but didn't save successfully! What the fuck happened???";
-                        }
-                    } else {
-                        success = false;
-                        break;
-                    }
-                }
-            }
-            ui->statusBar->removeWidget(statusProgressBar);
-            delete statusProgressBar;
-            // ui->tabWidget->setEnabled(true);
-            ui->comPortSelector->setEnabled(true);
-            if(!success) {
-                qDebug() << "Setting save failed, it failed!";
-            } else {
-                statusBar()->showMessage("Sent settings successfully!", 5000);
-                SyncSettings();
-                DiffUpdate();
-                ui->boardLabel->setText(PrettifyName());
-            }
-            serialActive = false;
-            serialQueue.clear();
-            if(!serialPort.atEnd()) {
-                serialPort.readAll();
-            }
-        } else {
-            qDebug() << "Wait, this port wasn't open to begin with!!! WTF SEONG!?!?";
-        }
-    } else {
-        statusBar()->showMessage("Save operation canceled.", 3000);
+
+void guiWindow::PreviewFlush()
+{
+    if(!previewPending || !serialPort.isOpen()) {
+        previewPending = 0;
+        return;
+    }
+    if(serialActive) {
+        // Something's holding the port, try again next tick.
+        previewTimer->start();
+        return;
+    }
+    // Xm.2 only changes the running value; nothing's saved until XS.
+    // Marked applied even if a write failed, since it may have landed anyway.
+    if(!PreviewSend(previewPending, gunConfig)) {
+        qDebug() << "Live preview: the gun didn't take every setting.";
     }
+    previewApplied |= previewPending;
+    previewPending = 0;
 }
 
 
-void guiWindow::on_comPortSelector_currentIndexChanged(int index)
+// Sends settings (bit = settingsTypes_e) from config the way a commit does: Xm first so the gun
+// listens, then one write at a time, each reply taken off the port before the next.
+bool guiWindow::PreviewSend(uint8_t settings, const gunConfig_s &config)
 {
-    // Indiscriminately clears the board layout views.
-    // yes, every time. goddammit QT.
-    // fuck it, it works until QT provides a better mechanism to remove widgets without deleting them.
-    if(pinBoxes[0]->count() > 0) {
-        for(uint8_t i = 0; i < 30; i++) {
-            pinBoxes[i]->clear();
-            delete pinBoxes[i];
-            delete padding[i];
-            delete pinLabel[i];
+    const bool wasActive = serialActive;
+    serialActive = true;
+    serialPort.write("Xm");
+    serialPort.waitForBytesWritten(1000);
+    while(!serialPort.atEnd()) {
+        serialPort.readLine();
+    }
+    bool success = true;
+    for(uint8_t i = 0; i < 8 && success; i++) {
+        if(settings & (1 << i)) {
+            success = CommitSend(FieldWrite(config, fieldSetting + i));
         }
-        delete centerPic;
     }
+    serialActive = wasActive;
+    return success;
+}
 
-    // delete PinsCenter;
-    // delete PinsLeft;
-    // delete PinsRight;
 
-    // PinsCenter = new QVBoxLayout();
-    // PinsCenterSub = new QGridLayout();
-    // PinsLeft = new QGridLayout();
-    // PinsRight = new QGridLayout();
+// Puts anything previewed but not saved back to what's in the gun's flash.
+void guiWindow::PreviewRevert()
+{
+    previewPending = 0;
+    previewTimer->stop();
+    if(!previewApplied || !serialPort.isOpen()) {
+        previewApplied = 0;
+        return;
+    }
+    if(!PreviewSend(previewApplied, gunConfig_orig)) {
+        qDebug() << "Live preview: couldn't put every previewed setting back; unplugging the gun will.";
+    }
+    previewApplied = 0;
+}
 
-    // ui->PinsTopHalf->addLayout(PinsLeft);
-    // ui->PinsTopHalf->addLayout(PinsCenter);
-    // ui->PinsTopHalf->addLayout(PinsRight);
 
-    for(uint8_t i = 0; i < 30; i++) {
-        pinBoxes[i] = new QComboBox();
-        pinBoxes[i]->setSizePolicy(QSizePolicy::Fixed,QSizePolicy::Fixed);
-        connect(pinBoxes[i], SIGNAL(activated(int)), this, SLOT(pinBoxes_activated(int)));
-        padding[i] = new QWidget();
-        padding[i]->setMinimumHeight(25);
-        pinLabel[i] = new QLabel(QString("<GPIO%1>").arg(i));
-        pinLabel[i]->setEnabled(false);
-        pinLabel[i]->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+void guiWindow::livePreviewToggle_toggled(bool checked)
+{
+    if(checked) {
+        // Start from whatever's already been changed.
+        uint8_t changed = 0;
+        for(uint8_t i = 0; i < 8; i++) {
+            if(gunConfig.settings[i] != gunConfig_orig.settings[i]) {
+                changed |= 1 << i;
+            }
+        }
+        if(changed & PREVIEW_SETTINGS) {
+            PreviewQueue(changed & PREVIEW_SETTINGS);
+        }
+        statusBar()->showMessage("Live preview on: rumble & solenoid changes apply immediately, but aren't saved until you confirm.", 5000);
+    } else {
+        PreviewRevert();
+    }
+}
+
+
+// Label showing one of a profile's scale/center values.
+static QLabel *ProfileLabel(uint8_t slot, uint8_t field)
+{
+    switch(field) {
+    case profileXScale:
+        return xScale[slot];
+    case profileYScale:
+        return yScale[slot];
+    case profileXCenter:
+        return xCenter[slot];
+    default:
+        return yCenter[slot];
+    }
+}
+
+
+void guiWindow::SetProfileField(uint8_t slot, uint8_t field, int32_t value)
+{
+    uint8_t index = fieldProfile + slot * profileFieldsCount + field;
+    // Scales/centers come from calibrating on the gun itself, not from edits here.
+    if(field == profileIrSensitivity || field == profileRunMode) {
+        FieldEdited(index, FieldValue(index), value);
+    }
+    FieldSet(gunConfig, index, value);
+    FieldDirty(index, FieldValue(index, true) != value);
+}
+
+
+void guiWindow::SetSelectedProfile(uint8_t slot)
+{
+    board.selectedProfile = slot;
+    FieldDirty(fieldSelectedProfile, board.previousProfile != slot);
+}
+
+
+// Records and rechecks whatever inputs moved since before, after the pin mapping was edited.
+void guiWindow::PinsChanged(const pinMap_s &before)
+{
+    uint32_t inputs = gunConfig.pins.InputsDiff(before);
+    for(uint8_t i = 0; i < INPUTS_COUNT; i++) {
+        if(inputs & (1u << i)) {
+            FieldEdited(fieldInputPin + i, before.inputPin[i], gunConfig.pins.inputPin[i]);
+            FieldDirty(fieldInputPin + i, FieldDiffers(fieldInputPin + i));
+        }
+    }
+}
+
+
+// For when custom pins gets toggled, which changes whether the mapping counts at all.
+void guiWindow::PinsDirtyRecheck()
+{
+    for(uint8_t i = 0; i < INPUTS_COUNT; i++) {
+        FieldDirty(fieldInputPin + i, FieldDiffers(fieldInputPin + i));
+    }
+}
+
+
+// Adds an edit made from the UI to the undo history.
+void guiWindow::FieldEdited(uint8_t field, int32_t from, int32_t to)
+{
+    if(!historyReplaying) {
+        history.Record(field, from, to);
+    }
+}
+
+
+// Sets a field to value through its widget, same as if it was edited by hand.
+// Used to play back the undo history.
+void guiWindow::ApplyField(uint8_t field, int32_t value)
+{
+    if(field == fieldBool + customPins) {
+        customPinsToggle->setChecked(value);
+    } else if(field < fieldSetting) {
+        uint8_t index = field - fieldBool;
+        if(boolWidgets[index]) {
+            boolWidgets[index]->setChecked(value);
+        } else {
+            SetBool(index, value);
+        }
+    } else if(field < fieldInputPin) {
+        uint8_t index = field - fieldSetting;
+        if(settingWidgets[index]) {
+            settingWidgets[index]->setValue(value);
+        } else {
+            SetSetting(index, value);
+        }
+    } else if(field < fieldTinyUSBid) {
+        pinMap_s before = gunConfig.pins;
+        FieldSet(gunConfig, field, value);
+        BoxesSync();
+        PinsChanged(before);
+    } else if(field >= fieldProfile) {
+        uint8_t slot = (field - fieldProfile) / profileFieldsCount;
+        uint8_t profileField = (field - fieldProfile) % profileFieldsCount;
+        if(profileField == profileIrSensitivity) {
+            irSens[slot]->setCurrentIndex(value);
+            irSensOldIndex[slot] = value;
+        } else if(profileField == profileRunMode) {
+            runMode[slot]->setCurrentIndex(value);
+            runModeOldIndex[slot] = value;
+        } else {
+            ProfileLabel(slot, profileField)->setText(QString::number(value));
+        }
+        SetProfileField(slot, profileField, value);
+    }
+}
+
+
+void guiWindow::HistoryStep(bool redo)
+{
+    historyReplaying = true;
+    auto apply = [this](uint8_t field, int32_t value) {
+        ApplyField(field, value);
+    };
+    int field = redo ? history.Redo(apply) : history.Undo(apply);
+    historyReplaying = false;
+    if(field >= 0) {
+        statusBar()->showMessage(QString("%1 %2").arg(redo ? "Redid" : "Undid", FieldName(field)), 3000);
+    }
+}
+
+
+void guiWindow::LibraryRefresh()
+{
+    libraryList->clear();
+    QString gun = libraryGunOnly->isChecked() ? cacheKey : QString();
+    for(int id : profileLibrary.Search(librarySearch->text(), gun)) {
+        const libraryProfile_s *entry = profileLibrary.Get(id);
+        QString label = entry->display.isEmpty() ? entry->name : QString("%1 (%2)").arg(entry->name, entry->display);
+        QListWidgetItem *item = new QListWidgetItem(label, libraryList);
+        item->setData(Qt::UserRole, id);
+        item->setToolTip(QString("xScale %1, yScale %2, xCenter %3, yCenter %4")
+                         .arg(entry->profile.xScale).arg(entry->profile.yScale).arg(entry->profile.xCenter).arg(entry->profile.yCenter));
+    }
+}
+
+
+// Saves the selected profile slot to the library under a name and display of the user's choosing.
+void guiWindow::LibrarySave()
+{
+    uint8_t slot = board.selectedProfile;
+    bool ok;
+    QString name = QInputDialog::getText(this, "Save Profile", QString("Name for profile %1:").arg(slot + 1),
+                                         QLineEdit::Normal, QString(), &ok).trimmed();
+    if(!ok || name.isEmpty()) {
+        return;
+    }
+    QString display = QInputDialog::getItem(this, "Save Profile", "Screen/cabinet it's calibrated for (optional):",
+                                            profileLibrary.Displays(), 0, true, &ok).trimmed();
+    if(!ok) {
+        return;
+    }
+    libraryProfile_s entry;
+    entry.name = name;
+    entry.gunKey = cacheKey;
+    entry.display = display;
+    entry.profile = gunConfig.profiles[slot];
+    profileLibrary.Add(entry);
+    LibraryRefresh();
+    statusBar()->showMessage(QString("Saved profile %1 as \"%2\".").arg(slot + 1).arg(name), 3000);
+}
+
+
+// Loads the picked library profile's IR sensitivity and run mode into the selected slot. It goes
+// through the same path as hand edits, so only the fields that differ get marked (and later
+// written), as one undo step. Its scales/centers are only shown: the gun has no command to set them.
+void guiWindow::LibraryLoad()
+{
+    QListWidgetItem *item = libraryList->currentItem();
+    if(!item) {
+        return;
+    }
+    const libraryProfile_s *entry = profileLibrary.Get(item->data(Qt::UserRole).toInt());
+    if(!entry) {
+        return;
+    }
+    uint8_t slot = board.selectedProfile;
+    gunConfig_s loaded = gunConfig;
+    loaded.profiles[slot] = entry->profile;
+    history.BeginGroup();
+    for(uint8_t i = profileIrSensitivity; i < profileFieldsCount; i++) {
+        uint8_t field = fieldProfile + slot * profileFieldsCount + i;
+        if(FieldGet(loaded, field) != FieldValue(field)) {
+            ApplyField(field, FieldGet(loaded, field));
+        }
+    }
+    history.EndGroup();
+    statusBar()->showMessage(QString("Loaded \"%1\" into profile %2; recalibrate on the gun for its scale and center (%3, %4 / %5, %6).")
+                             .arg(entry->name).arg(slot + 1).arg(entry->profile.xScale).arg(entry->profile.yScale)
+                             .arg(entry->profile.xCenter).arg(entry->profile.yCenter), 8000);
+}
+
+
+void guiWindow::LibraryDelete()
+{
+    QListWidgetItem *item = libraryList->currentItem();
+    if(!item) {
+        return;
+    }
+    profileLibrary.Remove(item->data(Qt::UserRole).toInt());
+    LibraryRefresh();
+}
+
+
+QString guiWindow::FieldName(uint8_t field) const
+{
+    if(field < fieldSetting) {
+        return boolNames[field - fieldBool];
+    } else if(field < fieldInputPin) {
+        return settingNames[field - fieldSetting];
+    } else if(field < fieldTinyUSBid) {
+        return QString("%1 Pin").arg(valuesNameList[field - fieldInputPin + 1]);
+    } else if(field == fieldTinyUSBid) {
+        return "TinyUSB ID";
+    } else if(field == fieldTinyUSBname) {
+        return "TinyUSB Name";
+    } else if(field == fieldSelectedProfile) {
+        return "Selected Profile";
+    }
+    uint8_t slot = (field - fieldProfile) / profileFieldsCount;
+    return QString("Profile %1 %2").arg(slot + 1).arg(profileFieldNames[(field - fieldProfile) % profileFieldsCount]);
+}
+
+
+// Names of everything that differs from the gun, in field order.
+QStringList guiWindow::ChangedFields() const
+{
+    QStringList names;
+    for(uint8_t i = 0; i < fieldsCount; i++) {
+        if(dirtyFields[i]) {
+            names.append(FieldName(i));
+        }
+    }
+    return names;
+}
+
+
+void guiWindow::SyncSettings()
+{
+    // Whatever was being previewed is in flash now.
+    previewPending = 0;
+    previewApplied = 0;
+    // Calibration rides along with the save too, so the whole config is in flash now.
+    memcpy(&gunConfig_orig, &gunConfig, sizeof(gunConfig_s));
+    board.previousProfile = board.selectedProfile;
+}
+
+
+QString PrettifyName()
+{
+    // if(!tinyUSBtable.tinyUSBname.isEmpty()) {
+    //     name = tinyUSBtable.tinyUSBname;
+    // } else {
+    //     name = "Unnamed Device";
+    // }
+    if(!board.def) {
+        return "";
+    }
+    return board.def->name;
+}
+
+
+// Value of a configFields_e in config, as shown in commit reports.
+static QString ConfigFieldText(const gunConfig_s &config, uint8_t field)
+{
+    switch(configSchema[field].kind) {
+    case fieldKindBool:
+        return FieldStored(config, field) ? "On" : "Off";
+    case fieldKindNumber:
+        return QString::number(FieldStored(config, field));
+    case fieldKindPin: {
+        int32_t pin = FieldStored(config, field);
+        return pin < 0 ? "Unmapped" : QString("GPIO %1").arg(pin);
+    }
+    case fieldKindText:
+        return FieldString(config, field);
+    default:
+        return "";
+    }
+}
+
+
+// Xm write that puts field's current (or as-loaded, if orig) value on the gun.
+// Empty for fields that aren't written this way (profile selection is instant).
+QString guiWindow::FieldCommand(uint8_t field, bool orig) const
+{
+    return FieldWrite(orig ? gunConfig_orig : gunConfig, field);
+}
+
+
+// Sends one commit write and waits for the gun to take it.
+bool guiWindow::CommitSend(const QString &command)
+{
+    serialPort.write(command.toLocal8Bit());
+    serialPort.waitForBytesWritten(2000);
+    if(!serialPort.waitForReadyRead(2000)) {
+        return false;
     }
+    QString buffer = serialPort.readLine();
+    return buffer.contains("OK:") || buffer.contains("NOENT:");
+}
+
 
+// Reads the whole config back off the gun in the middle of a commit.
+bool guiWindow::CommitReadBack(gunConfig_s &device)
+{
+    while(!serialPort.atEnd()) {
+        serialPort.readLine();
+    }
+    device.Clear();
+    bool loaded = SerialLoad(device);
+    // SerialLoad lets go of the port when it's done, but we aren't.
+    serialActive = true;
+    if(loaded) {
+        TinyUSBRead(device);
+    }
+    return loaded;
+}
+
+
+// Puts back the as-loaded value of every changed field among the first `touched` writes
+// of a failed commit, then tells the user what the gun actually holds for each of them.
+void guiWindow::CommitRollback(const QVector<commitWrite_s> &writes, int touched, const QString &failure)
+{
+    QVector<uint8_t> changed;
+    for(int i = 0; i < touched; i++) {
+        if(FieldDiffers(writes[i].field)) {
+            changed.append(writes[i].field);
+        }
+    }
+    while(!serialPort.atEnd()) {
+        serialPort.readLine();
+    }
+    // A write that fails here shows up in the read-back below.
+    for(uint8_t field : changed) {
+        CommitSend(FieldCommand(field, true));
+    }
+
+    gunConfig_s device;
+    bool readBack = CommitReadBack(device);
+    const gunConfig_s &saved = gunConfig_orig;
+    const gunConfig_s &wanted = gunConfig;
+    bool restored = readBack;
+    QStringList report;
+    for(uint8_t field : changed) {
+        QString now = readBack ? ConfigFieldText(device, field) : "Unknown";
+        if(readBack && now == ConfigFieldText(saved, field)) {
+            report.append(QString("%1: back to %2").arg(FieldName(field), now));
+        } else {
+            restored = false;
+            report.append(QString("%1: %2 (saved %3, wanted %4)").arg(FieldName(field), now, ConfigFieldText(saved, field), ConfigFieldText(wanted, field)));
+        }
+    }
+
+    QMessageBox messageBox;
+    messageBox.setWindowTitle("Commit Failed");
+    messageBox.setIcon(QMessageBox::Warning);
+    messageBox.setText(failure);
+    if(restored) {
+        messageBox.setInformativeText("Nothing was saved, and every setting that had already been sent was put back.\nThe gun is running its saved settings.");
+    } else {
+        messageBox.setInformativeText("Nothing was saved, but not everything could be put back; see the details for what the gun holds now.\nUnplugging the gun will bring back its saved settings.");
+    }
+    if(!report.isEmpty()) {
+        messageBox.setDetailedText(report.join("\n"));
+    }
+    messageBox.exec();
+}
+
+
+// Sends every setting that differs from the gun, checks it took them and saves; see CommitRollback for failures.
+bool guiWindow::CommitSettings()
+{
+    if(serialPort.isOpen()) {
+        serialActive = true;
+        // send a signal so the gun pauses its test outputs for the save op.
+        serialPort.write("Xm");
+        serialPort.waitForBytesWritten(1000);
+
+        QProgressBar *statusProgressBar = new QProgressBar();
+        ui->statusBar->addPermanentWidget(statusProgressBar);
+        // ui->tabWidget->setEnabled(false);
+        ui->comPortSelector->setEnabled(false);
+        ui->confirmButton->setEnabled(false);
+
+        // Every write of the commit, tagged with the field it carries,
+        // so a failed commit knows exactly what to put back.
+        // The gun already holds everything that matches what was loaded off it, so only changes go out.
+        commitWrites = 0;
+        QVector<commitWrite_s> serialQueue;
+        for(uint8_t field = 0; field < fieldsCount; field++) {
+            const QString command = FieldCommand(field);
+            if(command.isEmpty() || !FieldDiffers(field)) {
+                continue;
+            }
+            // Pins only count while the custom mapping's on.
+            if(configSchema[field].kind == fieldKindPin && !gunConfig.bools[customPins]) {
+                continue;
+            }
+            // An empty name would wipe the gun's own.
+            if(field == fieldTinyUSBname && !gunConfig.tinyUSBname[0]) {
+                continue;
+            }
+            serialQueue.append({field, command});
+        }
+
+        // writes, then the read-back, then the save
+        statusProgressBar->setRange(0, serialQueue.length() + 2);
+        bool success = true;
+        QString failure;
+
+        // throw out whatever's in the buffer if there's anything there.
+        while(!serialPort.atEnd()) {
+            serialPort.readLine();
+        }
+
+        int sent = 0;
+        for(; sent < serialQueue.length(); sent++) {
+            if(!CommitSend(serialQueue[sent].command)) {
+                failure = QString("The gun didn't accept the new %1.").arg(FieldName(serialQueue[sent].field));
+                success = false;
+                break;
+            }
+            statusProgressBar->setValue(sent + 1);
+        }
+
+        // Nothing's in flash until XS, so check the gun really holds what we sent first.
+        if(success) {
+            gunConfig_s device;
+            if(!CommitReadBack(device)) {
+                failure = "Couldn't read the settings back from the gun to check them.";
+                success = false;
+            } else {
+                for(const commitWrite_s &write : serialQueue) {
+                    if(!FieldEqual(device, gunConfig, write.field)) {
+                        failure = QString("The gun reported back the wrong %1.").arg(FieldName(write.field));
+                        success = false;
+                        break;
+                    }
+                }
+            }
+            statusProgressBar->setValue(statusProgressBar->value() + 1);
+        }
+
+        if(success) {
+            success = false;
+            serialPort.write("XS");
+            serialPort.waitForBytesWritten(2000);
+            if(serialPort.waitForReadyRead(2000)) {
+                QString buffer = serialPort.readLine();
+                if(buffer.contains("Saving preferences...")) {
+                    if(!serialPort.canReadLine()) {
+                        serialPort.waitForReadyRead(2000);
+                    }
+                    buffer = serialPort.readLine();
+                    success = buffer.contains("Settings saved to");
+                }
+            }
+            if(!success) {
+                failure = "The gun didn't confirm saving the settings.";
+            }
+            // because there's probably some leftover bytes that might congest things:
+            while(!serialPort.atEnd()) {
+                serialPort.readLine();
+            }
+            statusProgressBar->setValue(statusProgressBar->value() + 1);
+        }
+
+        if(!success) {
+            qDebug() << "Setting save failed:" << failure;
+            // The write that failed may still have landed, so it gets put back too.
+            CommitRollback(serialQueue, qMin(sent + 1, serialQueue.length()), failure);
+        }
+        ui->statusBar->removeWidget(statusProgressBar);
+        delete statusProgressBar;
+        // ui->tabWidget->setEnabled(true);
+        ui->comPortSelector->setEnabled(true);
+        if(success) {
+            commitWrites = serialQueue.length();
+            statusBar()->showMessage("Sent settings successfully!", 5000);
+            SyncSettings();
+            CacheStore();
+            DiffUpdate();
+            ui->boardLabel->setText(PrettifyName());
+        } else {
+            // Still unsaved, so let it be tried again.
+            ConfirmButtonUpdate();
+        }
+        serialActive = false;
+        if(!serialPort.atEnd()) {
+            serialPort.readAll();
+        }
+        return success;
+    } else {
+        qDebug() << "Wait, this port wasn't open to begin with!!! WTF SEONG!?!?";
+        return false;
+    }
+}
+
+
+void guiWindow::on_confirmButton_clicked()
+{
+    if(!offlineKey.isEmpty()) {
+        OfflineStage();
+        return;
+    }
+    QMessageBox messageBox;
+    messageBox.setText("Are these settings okay?");
+    messageBox.setInformativeText("These settings will be committed to your lightgun. Is that okay?");
+    messageBox.setDetailedText("Changed:\n" + ChangedFields().join("\n"));
+    messageBox.setWindowTitle("Commit Confirmation");
+    messageBox.setIcon(QMessageBox::Information);
+    messageBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+    messageBox.setDefaultButton(QMessageBox::Yes);
+    int value = messageBox.exec();
+    if(value == QMessageBox::Yes) {
+        CommitSettings();
+    } else {
+        statusBar()->showMessage("Save operation canceled.", 3000);
+    }
+}
+
+
+// Puts the loaded (or offline) config into every settings widget, and starts its edit history afresh.
+void guiWindow::ConfigWidgetsRefresh()
+{
+    PinBoxesRefresh();
+    ui->boardLabel->setText(PrettifyName());
+
+    // ui->tabWidget->setEnabled(true);
+    {
+        // PinBoxesRefresh already loaded the right mapping for this.
+        const QSignalBlocker blocker(customPinsToggle);
+        customPinsToggle->setChecked(gunConfig.bools[customPins]);
+    }
+    autoPinsBtn->setChecked(false);
+    autoPinsBtn->setEnabled(gunConfig.bools[customPins]);
+    for(uint8_t i = 0; i < 8; i++) {
+        if(boolWidgets[i]) {
+            boolWidgets[i]->setChecked(gunConfig.bools[i]);
+        }
+        if(settingWidgets[i]) {
+            settingWidgets[i]->setValue(gunConfig.settings[i]);
+        }
+    }
+    DiffUpdate();
+    // Edits made to a previous gun don't apply to this one.
+    history.Clear();
+    if(libraryGunOnly->isChecked()) {
+        LibraryRefresh();
+    }
+}
+
+
+void guiWindow::on_comPortSelector_currentIndexChanged(int index)
+{
     if(index > 0) {
         qDebug() << "COM port set to" << ui->comPortSelector->currentIndex();
+        // Whatever was being prepared offline isn't for this gun.
+        offlineKey.clear();
         // Clear stale states if any, and unmount old board if mounted.
         if(testMode) {
             testMode = false;
             ui->testView->setEnabled(false);
             ui->buttonsTestArea->setEnabled(true);
             ui->testBtn->setText("Enable IR Test Mode");
-            // ui->pinsTab->setEnabled(true);
+            pinsTab->setEnabled(true);
             ui->settingsTab->setEnabled(true);
             ui->profilesTab->setEnabled(true);
             ui->feedbackTestsBox->setEnabled(true);
@@ -952,6 +1586,7 @@ void guiWindow::on_comPortSelector_currentIndexChanged(int index)
             serialActive = false;
         }
         if(serialPort.isOpen()) {
+            PreviewRevert();
             serialActive = true;
             serialPort.write("XE");
             serialPort.waitForBytesWritten(2000);
@@ -960,466 +1595,29 @@ void guiWindow::on_comPortSelector_currentIndexChanged(int index)
             serialPort.close();
             serialActive = false;
         }
-        if(!SerialInit(index - 1)) {
+        QVariant port = ui->comPortSelector->itemData(index);
+        if(!port.isValid() || !SerialInit(port.toInt())) {
             ui->comPortSelector->setCurrentIndex(0);
         } else {
-            // switch(board.type) {
-            // case rpipico:
-            // {
-            //     // update box types
-            //     for(uint8_t i = 0; i < 30; i++) {
-            //         pinBoxes[i]->addItems(valuesNameList);
-            //         if(rpipicoLayout[i].pinType == pinDigital) {
-            //             pinBoxes[i]->removeItem(25);
-            //             pinBoxes[i]->removeItem(24);
-            //             // replace "Temp Sensor" with a separator
-            //             // then remove the presumably bumped up temp sensor index.
-            //             pinBoxes[i]->insertSeparator(16);
-            //             pinBoxes[i]->removeItem(17);
-            //         }
-            //     }
-
-            //     BoxesUpdate();
-
-            //     centerPic = new QSvgWidget(":/boardPics/pico.svg");
-            //     QSvgRenderer *picRenderer = centerPic->renderer();
-            //     picRenderer->setAspectRatioMode(Qt::KeepAspectRatio);
-            //     ui->boardLabel->setText(PrettifyName());
-
-            //     // left side (has 1 row of top padding)
-            //     // PinsLeft->addWidget(padding[0], 0, 1);
-            //     // PinsLeft->addWidget(pinBoxes[0], 1, 0),
-            //     //     PinsLeft->addWidget(pinLabel[0], 1, 1);
-            //     // PinsLeft->addWidget(pinBoxes[1], 2, 0),
-            //     //     PinsLeft->addWidget(pinLabel[1], 2, 1);
-            //     // PinsLeft->addWidget(padding[1], 3, 1);
-            //     // PinsLeft->addWidget(pinBoxes[2], 4, 0),
-            //     //     PinsLeft->addWidget(pinLabel[2], 4, 1);
-            //     // PinsLeft->addWidget(pinBoxes[3], 5, 0),
-            //     //     PinsLeft->addWidget(pinLabel[3], 5, 1);
-            //     // PinsLeft->addWidget(pinBoxes[4], 6, 0),
-            //     //     PinsLeft->addWidget(pinLabel[4], 6, 1);
-            //     // PinsLeft->addWidget(pinBoxes[5], 7, 0),
-            //     //     PinsLeft->addWidget(pinLabel[5], 7, 1);
-            //     // PinsLeft->addWidget(padding[2], 8, 1);
-            //     // PinsLeft->addWidget(pinBoxes[6], 9, 0),
-            //     //     PinsLeft->addWidget(pinLabel[6], 9, 1);
-            //     // PinsLeft->addWidget(pinBoxes[7], 10, 0),
-            //     //     PinsLeft->addWidget(pinLabel[7], 10, 1);
-            //     // PinsLeft->addWidget(pinBoxes[8], 11, 0),
-            //     //     PinsLeft->addWidget(pinLabel[8], 11, 1);
-            //     // PinsLeft->addWidget(pinBoxes[9], 12, 0),
-            //     //     PinsLeft->addWidget(pinLabel[9], 12, 1);
-            //     // PinsLeft->addWidget(padding[3], 13, 1);
-            //     // PinsLeft->addWidget(pinBoxes[10], 14, 0),
-            //     //     PinsLeft->addWidget(pinLabel[10], 14, 1);
-            //     // PinsLeft->addWidget(pinBoxes[11], 15, 0, 1, 1),
-            //     //     PinsLeft->addWidget(pinLabel[11], 15, 1);
-            //     // PinsLeft->addWidget(pinBoxes[12], 16, 0),
-            //     //     PinsLeft->addWidget(pinLabel[12], 16, 1);
-            //     // PinsLeft->addWidget(pinBoxes[13], 17, 0),
-            //     //     PinsLeft->addWidget(pinLabel[13], 17, 1);
-            //     // PinsLeft->addWidget(padding[4], 18, 1);
-            //     // PinsLeft->addWidget(pinBoxes[14], 19, 0),
-            //     //     PinsLeft->addWidget(pinLabel[14], 19, 1);
-            //     // PinsLeft->addWidget(pinBoxes[15], 20, 0),
-            //     //     PinsLeft->addWidget(pinLabel[15], 20, 1);
-
-            //     // // right side (has 1 row of top padding)
-            //     // PinsRight->addWidget(padding[5], 0, 0); // top
-            //     // PinsRight->addWidget(padding[6], 1, 1);
-            //     // PinsRight->addWidget(padding[7], 2, 1);
-            //     // PinsRight->addWidget(padding[8], 3, 1); // gnd
-            //     // PinsRight->addWidget(padding[9], 4, 1);
-            //     // PinsRight->addWidget(padding[10], 5, 1);
-            //     // PinsRight->addWidget(padding[11], 6, 1);
-            //     // PinsRight->addWidget(pinBoxes[28], 7, 1),
-            //     //     PinsRight->addWidget(pinLabel[28], 7, 0);
-            //     // PinsRight->addWidget(padding[12], 8, 0); // gnd
-            //     // PinsRight->addWidget(pinBoxes[27], 9, 1),
-            //     //     PinsRight->addWidget(pinLabel[27], 9, 0);
-            //     // PinsRight->addWidget(pinBoxes[26], 10, 1),
-            //     //     PinsRight->addWidget(pinLabel[26], 10, 0);
-            //     // PinsRight->addWidget(padding[13], 11, 1);
-            //     // PinsRight->addWidget(pinBoxes[22], 12, 1),
-            //     //     PinsRight->addWidget(pinLabel[22], 12, 0);
-            //     // PinsRight->addWidget(padding[14], 13, 0); // gnd
-            //     // PinsRight->addWidget(padding[15], 14, 1);     // data
-            //     // PinsRight->addWidget(padding[16], 15, 1);     // clock
-            //     // PinsRight->addWidget(pinBoxes[19], 16, 1),
-            //     //     PinsRight->addWidget(pinLabel[19], 16, 0);
-            //     // PinsRight->addWidget(pinBoxes[18], 17, 1),
-            //     //     PinsRight->addWidget(pinLabel[18], 17, 0);
-            //     // PinsRight->addWidget(padding[17], 18, 0); // gnd
-            //     // PinsRight->addWidget(pinBoxes[17], 19, 1),
-            //     //     PinsRight->addWidget(pinLabel[17], 19, 0);
-            //     // PinsRight->addWidget(pinBoxes[16], 20, 1),
-            //     //     PinsRight->addWidget(pinLabel[16], 20, 0);
-
-            //     // // center
-            //     // PinsCenter->addWidget(centerPic);
-            //     // centerPic->setSizePolicy(QSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding));
-            //     break;
-            // }
-            // case adafruitItsyRP2040:
-            // {
-            //     // update box types
-            //     for(uint8_t i = 0; i < 30; i++) {
-            //         pinBoxes[i]->addItems(valuesNameList);
-            //         if(adafruitItsyRP2040Layout[i].pinType == pinDigital) {
-            //             pinBoxes[i]->removeItem(25);
-            //             pinBoxes[i]->removeItem(24);
-            //             // replace "Temp Sensor" with a separator
-            //             // then remove the presumably bumped up temp sensor index.
-            //             pinBoxes[i]->insertSeparator(16);
-            //             pinBoxes[i]->removeItem(17);
-            //         }
-            //     }
-
-            //     BoxesUpdate();
-
-            //     centerPic = new QSvgWidget(":/boardPics/adafruitItsy2040.svg");
-            //     QSvgRenderer *picRenderer = centerPic->renderer();
-            //     picRenderer->setAspectRatioMode(Qt::KeepAspectRatio);
-            //     ui->boardLabel->setText(PrettifyName());
-
-            //     // left side
-            //     PinsLeft->addWidget(padding[0], 0, 1);
-            //     PinsLeft->addWidget(padding[1], 1, 1);
-            //     PinsLeft->addWidget(padding[3], 2, 1);
-            //     PinsLeft->addWidget(padding[4], 3, 1);
-            //     PinsLeft->addWidget(pinBoxes[26], 4, 0),
-            //         PinsLeft->addWidget(pinLabel[26], 4, 1);
-            //     PinsLeft->addWidget(pinBoxes[27], 5, 0),
-            //         PinsLeft->addWidget(pinLabel[27], 5, 1);
-            //     PinsLeft->addWidget(pinBoxes[28], 6, 0),
-            //         PinsLeft->addWidget(pinLabel[28], 6, 1);
-            //     PinsLeft->addWidget(pinBoxes[29], 7, 0),
-            //         PinsLeft->addWidget(pinLabel[29], 7, 1);
-            //     PinsLeft->addWidget(pinBoxes[24], 8, 0),
-            //         PinsLeft->addWidget(pinLabel[24], 8, 1);
-            //     PinsLeft->addWidget(pinBoxes[25], 9, 0),
-            //         PinsLeft->addWidget(pinLabel[25], 9, 1);
-            //     PinsLeft->addWidget(pinBoxes[18], 10, 0),
-            //         PinsLeft->addWidget(pinLabel[18], 10, 1);
-            //     PinsLeft->addWidget(pinBoxes[19], 11, 0),
-            //         PinsLeft->addWidget(pinLabel[19], 11, 1);
-            //     PinsLeft->addWidget(pinBoxes[20], 12, 0),
-            //         PinsLeft->addWidget(pinLabel[20], 12, 1);
-            //     PinsLeft->addWidget(pinBoxes[12], 13, 0),
-            //         PinsLeft->addWidget(pinLabel[12], 13, 1);
-            //     PinsLeft->addWidget(padding[5], 14, 0),
-            //         PinsLeft->addWidget(padding[6], 14, 1);
-            //     PinsLeft->addWidget(padding[7], 15, 1);
-
-            //     // right side
-            //     PinsRight->addWidget(padding[8], 0, 1);
-            //     PinsRight->addWidget(padding[9], 1, 0),
-            //         PinsRight->addWidget(padding[10], 2, 1);
-            //     PinsRight->addWidget(pinBoxes[11], 3, 1),
-            //         PinsRight->addWidget(pinLabel[11], 3, 0);
-            //     PinsRight->addWidget(pinBoxes[10], 4, 1),
-            //         PinsRight->addWidget(pinLabel[10], 4, 0);
-            //     PinsRight->addWidget(pinBoxes[9], 5, 1),
-            //         PinsRight->addWidget(pinLabel[9], 5, 0);
-            //     PinsRight->addWidget(pinBoxes[8], 6, 1),
-            //         PinsRight->addWidget(pinLabel[8], 6, 0);
-            //     PinsRight->addWidget(pinBoxes[7], 7, 1),
-            //         PinsRight->addWidget(pinLabel[7], 7, 0);
-            //     PinsRight->addWidget(pinBoxes[6], 8, 1),
-            //         PinsRight->addWidget(pinLabel[6], 8, 0);
-            //     PinsRight->addWidget(padding[11], 9, 1);      // 5!
-            //     PinsRight->addWidget(padding[12], 10, 1);     // data
-            //     PinsRight->addWidget(padding[13], 11, 1);     // clock
-            //     PinsRight->addWidget(pinBoxes[0], 12, 1),
-            //         PinsRight->addWidget(pinLabel[0], 12, 0);
-            //     PinsRight->addWidget(pinBoxes[1], 13, 1),
-            //         PinsRight->addWidget(pinLabel[1], 13, 0);
-            //     PinsRight->addWidget(padding[14], 14, 1);
-            //     PinsRight->addWidget(padding[15], 15, 1);
-
-            //     // center
-            //     PinsCenter->addWidget(centerPic);
-            //     PinsCenter->addLayout(PinsCenterSub);
-            //     centerPic->setSizePolicy(QSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding));
-            //     PinsCenterSub->addWidget(pinBoxes[4], 1, 3),
-            //         PinsCenterSub->addWidget(pinLabel[4], 0, 3);
-            //     PinsCenterSub->addWidget(pinBoxes[5], 1, 2),
-            //         PinsCenterSub->addWidget(pinLabel[5], 0, 2);
-            //     break;
-            // }
-            // case adafruitKB2040:
-            // {
-            //     // update box types
-            //     for(uint8_t i = 0; i < 30; i++) {
-            //         pinBoxes[i]->addItems(valuesNameList);
-            //         if(adafruitKB2040Layout[i].pinType == pinDigital) {
-            //             pinBoxes[i]->removeItem(25);
-            //             pinBoxes[i]->removeItem(24);
-            //             // replace "Temp Sensor" with a separator
-            //             // then remove the presumably bumped up temp sensor index.
-            //             pinBoxes[i]->insertSeparator(16);
-            //             pinBoxes[i]->removeItem(17);
-            //         }
-            //     }
-
-            //     BoxesUpdate();
-
-            //     centerPic = new QSvgWidget(":/boardPics/adafruitKB2040.svg");
-            //     QSvgRenderer *picRenderer = centerPic->renderer();
-            //     picRenderer->setAspectRatioMode(Qt::KeepAspectRatio);
-            //     ui->boardLabel->setText(PrettifyName());
-
-            //     // left side
-            //     PinsLeft->addWidget(padding[0], 0, 1);        // D+
-            //     PinsLeft->addWidget(pinBoxes[0], 1, 0),
-            //         PinsLeft->addWidget(pinLabel[0], 1, 1);
-            //     PinsLeft->addWidget(pinBoxes[1], 2, 0),
-            //         PinsLeft->addWidget(pinLabel[1], 2, 1);
-            //     PinsLeft->addWidget(padding[1], 3, 1);        // gnd
-            //     PinsLeft->addWidget(padding[2], 4, 1);        // gnd
-            //     PinsLeft->addWidget(padding[3], 5, 1);        // data
-            //     PinsLeft->addWidget(padding[4], 6, 1);        // clock
-            //     PinsLeft->addWidget(pinBoxes[4], 7, 0),
-            //         PinsLeft->addWidget(pinLabel[4], 7, 1);
-            //     PinsLeft->addWidget(pinBoxes[5], 8, 0),
-            //         PinsLeft->addWidget(pinLabel[5], 8, 1);
-            //     PinsLeft->addWidget(pinBoxes[6], 9, 0),
-            //         PinsLeft->addWidget(pinLabel[6], 9, 1);
-            //     PinsLeft->addWidget(pinBoxes[7], 10, 0),
-            //         PinsLeft->addWidget(pinLabel[7], 10, 1);
-            //     PinsLeft->addWidget(pinBoxes[8], 11, 0),
-            //         PinsLeft->addWidget(pinLabel[8], 11, 1);
-            //     PinsLeft->addWidget(pinBoxes[9], 12, 0),
-            //         PinsLeft->addWidget(pinLabel[9], 12, 1);
-
-            //     // right side
-            //     PinsRight->addWidget(padding[5], 0, 0);       // D-
-            //     PinsRight->addWidget(padding[6], 1, 0);       // RAW
-            //     PinsRight->addWidget(padding[7], 2, 0);       // gnd
-            //     PinsRight->addWidget(padding[8], 3, 0);       // reset
-            //     PinsRight->addWidget(padding[9], 4, 0);       // 3.3v
-            //     PinsRight->addWidget(pinBoxes[29], 5, 1),
-            //         PinsRight->addWidget(pinLabel[29], 5, 0);
-            //     PinsRight->addWidget(pinBoxes[28], 6, 1),
-            //         PinsRight->addWidget(pinLabel[28], 6, 0);
-            //     PinsRight->addWidget(pinBoxes[27], 7, 1),
-            //         PinsRight->addWidget(pinLabel[27], 7, 0);
-            //     PinsRight->addWidget(pinBoxes[26], 8, 1),
-            //         PinsRight->addWidget(pinLabel[26], 8, 0);
-            //     PinsRight->addWidget(pinBoxes[18], 9, 1),
-            //         PinsRight->addWidget(pinLabel[18], 9, 0);
-            //     PinsRight->addWidget(pinBoxes[20], 10, 1),
-            //         PinsRight->addWidget(pinLabel[20], 10, 0);
-            //     PinsRight->addWidget(pinBoxes[19], 11, 1),
-            //         PinsRight->addWidget(pinLabel[19], 11, 0);
-            //     PinsRight->addWidget(pinBoxes[10], 12, 1),
-            //         PinsRight->addWidget(pinLabel[10], 12, 0);
-
-            //     // center
-            //     PinsCenter->addWidget(centerPic);
-            //     centerPic->setSizePolicy(QSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding));
-            //     break;
-            // }
-            // case arduinoNanoRP2040:
-            // {
-            //     for(uint8_t i = 0; i < 30; i++) {
-            //         pinBoxes[i]->addItems(valuesNameList);
-            //         if(arduinoNanoRP2040Layout[i].pinType == pinDigital) {
-            //             pinBoxes[i]->removeItem(25);
-            //             pinBoxes[i]->removeItem(24);
-            //             // replace "Temp Sensor" with a separator
-            //             // then remove the presumably bumped up temp sensor index.
-            //             pinBoxes[i]->insertSeparator(16);
-            //             pinBoxes[i]->removeItem(17);
-            //         }
-            //     }
-
-            //     BoxesUpdate();
-
-            //     centerPic = new QSvgWidget(":/boardPics/arduinoNano2040.svg");
-            //     QSvgRenderer *picRenderer = centerPic->renderer();
-            //     picRenderer->setAspectRatioMode(Qt::KeepAspectRatio);
-            //     PinsCenter->addWidget(centerPic);
-            //     ui->boardLabel->setText(PrettifyName());
-
-            //     // left side
-            //     PinsLeft->addWidget(padding[0], 0, 0); // top bumpdown
-            //     PinsLeft->addWidget(pinBoxes[6], 1, 0);
-            //     PinsLeft->addWidget(pinLabel[6], 1, 1);
-            //     PinsLeft->addWidget(padding[1], 2, 0);
-            //     PinsLeft->addWidget(padding[2], 3, 0);
-            //     PinsLeft->addWidget(pinBoxes[26], 4, 0);
-            //     PinsLeft->addWidget(pinLabel[26], 4, 1);
-            //     PinsLeft->addWidget(pinBoxes[27], 5, 0);
-            //     PinsLeft->addWidget(pinLabel[27], 5, 1);
-            //     PinsLeft->addWidget(pinBoxes[28], 6, 0);
-            //     PinsLeft->addWidget(pinLabel[28], 6, 1);
-            //     PinsLeft->addWidget(pinBoxes[29], 7, 0);
-            //     PinsLeft->addWidget(pinLabel[29], 7, 1);
-            //     PinsLeft->addWidget(padding[3], 8, 0); // data
-            //     PinsLeft->addWidget(padding[4], 9, 0); // clock
-            //     PinsLeft->addWidget(padding[5], 10, 0); // A6 - unused
-            //     PinsLeft->addWidget(padding[6], 11, 0);// A7 - unused
-            //     PinsLeft->addWidget(padding[7], 12, 0);// 5V
-            //     PinsLeft->addWidget(padding[8], 13, 0);// REC?
-            //     PinsLeft->addWidget(padding[9], 14, 0);// gnd
-            //     PinsLeft->addWidget(padding[10], 15, 0);// 5v input
-            //     PinsLeft->addWidget(padding[11], 16, 0);// bottom bumpup
-
-            //     // right side
-            //     PinsRight->addWidget(padding[12], 0, 0);
-            //     PinsRight->addWidget(pinBoxes[4], 1, 1);
-            //     PinsRight->addWidget(pinLabel[4], 1, 0);
-            //     PinsRight->addWidget(pinBoxes[7], 2, 1);
-            //     PinsRight->addWidget(pinLabel[7], 2, 0);
-            //     PinsRight->addWidget(pinBoxes[5], 3, 1);
-            //     PinsRight->addWidget(pinLabel[5], 3, 0);
-            //     PinsRight->addWidget(pinBoxes[21], 4, 1);
-            //     PinsRight->addWidget(pinLabel[21], 4, 0);
-            //     PinsRight->addWidget(pinBoxes[20], 5, 1);
-            //     PinsRight->addWidget(pinLabel[20], 5, 0);
-            //     PinsRight->addWidget(pinBoxes[19], 6, 1);
-            //     PinsRight->addWidget(pinLabel[19], 6, 0);
-            //     PinsRight->addWidget(pinBoxes[18], 7, 1);
-            //     PinsRight->addWidget(pinLabel[18], 7, 0);
-            //     PinsRight->addWidget(pinBoxes[17], 8, 1);
-            //     PinsRight->addWidget(pinLabel[17], 8, 0);
-            //     PinsRight->addWidget(pinBoxes[16], 9, 1);
-            //     PinsRight->addWidget(pinLabel[16], 9, 0);
-            //     PinsRight->addWidget(pinBoxes[15], 10, 1);
-            //     PinsRight->addWidget(pinLabel[15], 10, 0);
-            //     PinsRight->addWidget(pinBoxes[25], 11, 1);
-            //     PinsRight->addWidget(pinLabel[25], 11, 0);
-            //     PinsRight->addWidget(padding[13], 12, 0);
-            //     PinsRight->addWidget(padding[14], 13, 0);
-            //     PinsRight->addWidget(pinBoxes[1], 14, 1);
-            //     PinsRight->addWidget(pinLabel[1], 14, 0);
-            //     PinsRight->addWidget(pinBoxes[0], 15, 1);
-            //     PinsRight->addWidget(pinLabel[0], 15, 0);
-            //     PinsRight->addWidget(padding[15], 16, 0);
-
-            //     // center
-            //     PinsCenter->addWidget(centerPic);
-            //     break;
-            // }
-            // case generic:
-            //     // update box types
-            //     for(uint8_t i = 0; i < 30; i++) {
-            //         pinBoxes[i]->addItems(valuesNameList);
-            //         if(genericLayout[i].pinType == pinDigital) {
-            //             pinBoxes[i]->removeItem(25);
-            //             pinBoxes[i]->removeItem(24);
-            //             // replace "Temp Sensor" with a separator
-            //             // then remove the presumably bumped up temp sensor index.
-            //             pinBoxes[i]->insertSeparator(16);
-            //             pinBoxes[i]->removeItem(17);
-            //         }
-            //     }
-
-            //     BoxesUpdate();
-
-            //     centerPic = new QSvgWidget(":/boardPics/unknown.svg");
-            //     QSvgRenderer *picRenderer = centerPic->renderer();
-            //     picRenderer->setAspectRatioMode(Qt::KeepAspectRatio);
-            //     ui->boardLabel->setText(PrettifyName());
-
-            //     // left side (has 1 row of top padding)
-            //     PinsLeft->addWidget(padding[0], 0, 1);
-            //     PinsLeft->addWidget(pinBoxes[0], 1, 0),
-            //         PinsLeft->addWidget(pinLabel[0], 1, 1);
-            //     PinsLeft->addWidget(pinBoxes[1], 2, 0),
-            //         PinsLeft->addWidget(pinLabel[1], 2, 1);
-            //     PinsLeft->addWidget(padding[1], 3, 1);
-            //     PinsLeft->addWidget(pinBoxes[2], 4, 0),
-            //         PinsLeft->addWidget(pinLabel[2], 4, 1);
-            //     PinsLeft->addWidget(pinBoxes[3], 5, 0),
-            //         PinsLeft->addWidget(pinLabel[3], 5, 1);
-            //     PinsLeft->addWidget(pinBoxes[4], 6, 0),
-            //         PinsLeft->addWidget(pinLabel[4], 6, 1);
-            //     PinsLeft->addWidget(pinBoxes[5], 7, 0),
-            //         PinsLeft->addWidget(pinLabel[5], 7, 1);
-            //     PinsLeft->addWidget(padding[2], 8, 1);
-            //     PinsLeft->addWidget(pinBoxes[6], 9, 0),
-            //         PinsLeft->addWidget(pinLabel[6], 9, 1);
-            //     PinsLeft->addWidget(pinBoxes[7], 10, 0),
-            //         PinsLeft->addWidget(pinLabel[7], 10, 1);
-            //     PinsLeft->addWidget(pinBoxes[8], 11, 0),
-            //         PinsLeft->addWidget(pinLabel[8], 11, 1);
-            //     PinsLeft->addWidget(pinBoxes[9], 12, 0),
-            //         PinsLeft->addWidget(pinLabel[9], 12, 1);
-            //     PinsLeft->addWidget(padding[3], 13, 1);
-            //     PinsLeft->addWidget(pinBoxes[10], 14, 0),
-            //         PinsLeft->addWidget(pinLabel[10], 14, 1);
-            //     PinsLeft->addWidget(pinBoxes[11], 15, 0, 1, 1),
-            //         PinsLeft->addWidget(pinLabel[11], 15, 1);
-            //     PinsLeft->addWidget(pinBoxes[12], 16, 0),
-            //         PinsLeft->addWidget(pinLabel[12], 16, 1);
-            //     PinsLeft->addWidget(pinBoxes[13], 17, 0),
-            //         PinsLeft->addWidget(pinLabel[13], 17, 1);
-            //     PinsLeft->addWidget(padding[4], 18, 1);
-            //     PinsLeft->addWidget(pinBoxes[14], 19, 0),
-            //         PinsLeft->addWidget(pinLabel[14], 19, 1);
-            //     PinsLeft->addWidget(pinBoxes[15], 20, 0),
-            //         PinsLeft->addWidget(pinLabel[15], 20, 1);
-
-            //     // right side (has 1 row of top padding)
-            //     PinsRight->addWidget(padding[5], 0, 0); // top
-            //     PinsRight->addWidget(padding[6], 1, 1);
-            //     PinsRight->addWidget(padding[7], 2, 1);
-            //     PinsRight->addWidget(padding[8], 3, 1); // gnd
-            //     PinsRight->addWidget(padding[9], 4, 1);
-            //     PinsRight->addWidget(padding[10], 5, 1);
-            //     PinsRight->addWidget(padding[11], 6, 1);
-            //     PinsRight->addWidget(pinBoxes[28], 7, 1),
-            //         PinsRight->addWidget(pinLabel[28], 7, 0);
-            //     PinsRight->addWidget(padding[12], 8, 0); // gnd
-            //     PinsRight->addWidget(pinBoxes[27], 9, 1),
-            //         PinsRight->addWidget(pinLabel[27], 9, 0);
-            //     PinsRight->addWidget(pinBoxes[26], 10, 1),
-            //         PinsRight->addWidget(pinLabel[26], 10, 0);
-            //     PinsRight->addWidget(padding[13], 11, 1);
-            //     PinsRight->addWidget(pinBoxes[22], 12, 1),
-            //         PinsRight->addWidget(pinLabel[22], 12, 0);
-            //     PinsRight->addWidget(padding[14], 13, 0); // gnd
-            //     PinsRight->addWidget(padding[15], 14, 1);     // data
-            //     PinsRight->addWidget(padding[16], 15, 1);     // clock
-            //     PinsRight->addWidget(pinBoxes[19], 16, 1),
-            //         PinsRight->addWidget(pinLabel[19], 16, 0);
-            //     PinsRight->addWidget(pinBoxes[18], 17, 1),
-            //         PinsRight->addWidget(pinLabel[18], 17, 0);
-            //     PinsRight->addWidget(padding[17], 18, 0); // gnd
-            //     PinsRight->addWidget(pinBoxes[17], 19, 1),
-            //         PinsRight->addWidget(pinLabel[17], 19, 0);
-            //     PinsRight->addWidget(pinBoxes[16], 20, 1),
-            //         PinsRight->addWidget(pinLabel[16], 20, 0);
-
-            //     // center
-            //     PinsCenter->addWidget(centerPic);
-            //     centerPic->setSizePolicy(QSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding));
-            //     break;
-            // }
-
-
-            // ui->tabWidget->setEnabled(true);
-            // ui->customPinsEnabled->setChecked(boolSettings[customPins]);
-//            ui->nunChuckToggle->setChecked(boolSettings[nunChuck]);
-            ui->rumbleToggle->setChecked(boolSettings[rumble]);
-            ui->solenoidToggle->setChecked(boolSettings[solenoid]);
-            ui->autofireToggle->setChecked(boolSettings[autofire]);
-            ui->holdToPauseToggle->setChecked(boolSettings[holdToPause]);
-            ui->rumbleIntensityBox->setValue(settingsTable[rumbleStrength]);
-            ui->rumbleLengthBox->setValue(settingsTable[rumbleInterval]);
-            ui->holdToPauseLengthBox->setValue(settingsTable[holdToPauseLength]);
-            ui->solenoidNormalIntervalBox->setValue(settingsTable[solenoidNormalInterval]);
-            ui->solenoidFastIntervalBox->setValue(settingsTable[solenoidFastInterval]);
-            ui->solenoidHoldLengthBox->setValue(settingsTable[solenoidHoldLength]);
-            ui->autofireWaitFactorBox->setValue(settingsTable[autofireWaitFactor]);
+            ConfigWidgetsRefresh();
+            FirmwareVersionsRefresh();
+            // Only a config actually read off the new firmware says what needs putting back.
+            if(update.stage == updateReconnect && cacheKey == update.key && configFresh) {
+                UpdateStage(updateRestore);
+                commitWrites = 0;
+            }
+            StagedApply();
+            if(update.stage == updateRestore) {
+                update.restored = commitWrites;
+            }
         }
     } else {
         ui->boardLabel->clear();
+        cacheKey.clear();
+        configFresh = false;
 
         if(serialPort.isOpen()) {
+            PreviewRevert();
             serialActive = true;
             serialPort.write("XE");
             serialPort.waitForBytesWritten(2000);
@@ -1431,7 +1629,7 @@ void guiWindow::on_comPortSelector_currentIndexChanged(int index)
                 ui->testView->setEnabled(false);
                 ui->buttonsTestArea->setEnabled(true);
                 ui->testBtn->setText("Enable IR Test Mode");
-                // ui->pinsTab->setEnabled(true);
+                pinsTab->setEnabled(true);
                 ui->settingsTab->setEnabled(true);
                 ui->profilesTab->setEnabled(true);
                 ui->feedbackTestsBox->setEnabled(true);
@@ -1445,44 +1643,221 @@ void guiWindow::on_comPortSelector_currentIndexChanged(int index)
     }
 }
 
-void guiWindow::pinBoxes_activated(int index)
+
+// Starts preparing a config for a gun that isn't plugged in, from the gun's last known
+// config, what's already queued for it, or a board's firmware defaults.
+void guiWindow::OfflineBegin()
 {
-    // Demultiplexing to figure out which "pin" this combobox that's calling correlates to.
-    uint8_t pin;
-    QObject* obj = sender();
-    for(uint8_t i = 0;;i++) {
-        if(obj == pinBoxes[i]) {
-            pin = i;
-            break;
+    QStringList guns = configCache.Keys() + stagedConfigs.Keys();
+    guns.removeDuplicates();
+    guns.sort();
+    bool ok;
+    QString key = QInputDialog::getItem(this, "Edit Offline", "Gun to prepare a config for\n(usb:<USB serial number> or tinyusb:<TinyUSB ID>):",
+                                        guns, 0, true, &ok).trimmed();
+    if(!ok || key.isEmpty()) {
+        return;
+    }
+    if(!key.startsWith("usb:") && !key.startsWith("tinyusb:")) {
+        PopupWindow("Unknown gun identity!", "Guns are identified as usb:<USB serial number> or tinyusb:<TinyUSB ID>.", "Oops!", 3);
+        return;
+    }
+
+    const stagedConfig_s *staged = stagedConfigs.Find(key);
+    const configCacheEntry_s *last = configCache.Last(key);
+    const QVector<const boardDef_s*> boards = boardRegistry.All();
+    QStringList bases;
+    if(staged) {
+        bases.append("Config already queued for this gun");
+    }
+    if(last) {
+        bases.append("Last config read from this gun");
+    }
+    for(const boardDef_s *def : boards) {
+        bases.append(QString("%1 defaults").arg(def->name));
+    }
+    int choice = bases.indexOf(QInputDialog::getItem(this, "Edit Offline", "Start from:", bases, 0, false, &ok));
+    if(!ok || choice < 0) {
+        return;
+    }
+
+    gunConfig_s config;
+    const boardDef_s *def;
+    offlineFields.reset();
+    if(staged && choice == 0) {
+        config = staged->config;
+        def = boardRegistry.Find(staged->boardId);
+        // Keep everything that was going to be applied before.
+        offlineFields = staged->fields;
+    } else if(last && choice == (staged ? 1 : 0)) {
+        config = last->config;
+        def = boardRegistry.Find(last->boardId);
+    } else {
+        config = ConfigDefaults();
+        def = boards[choice - (staged ? 1 : 0) - (last ? 1 : 0)];
+    }
+
+    // Offline edits mustn't end up on whatever gun is plugged in right now.
+    ui->comPortSelector->setCurrentIndex(0);
+    offlineKey = key;
+    board.def = def;
+    board.versionNumber = 0;
+    board.versionCodename.clear();
+    board.selectedProfile = 0;
+    board.previousProfile = 0;
+    selectedProfile[0]->setChecked(true);
+    ConfigApply(config);
+    ConfigWidgetsRefresh();
+    ui->boardLabel->setText(QString("Offline: %1 (%2)").arg(key, def->name));
+}
+
+
+// Queues the offline config for its gun. Everything settable here gets applied, except
+// calibration (which belongs to the screen the gun was calibrated on) unless it was changed on
+// purpose, and a blank TinyUSB ident, which would otherwise wipe the gun's own.
+void guiWindow::OfflineStage()
+{
+    stagedConfig_s staged;
+    staged.boardId = board.def ? board.def->id : "";
+    staged.config = gunConfig;
+    staged.fields = offlineFields | dirtyFields;
+    for(uint8_t i = fieldBool; i < fieldTinyUSBid; i++) {
+        staged.fields.set(i);
+    }
+    if(gunConfig.tinyUSBid[0]) {
+        staged.fields.set(fieldTinyUSBid);
+    }
+    if(gunConfig.tinyUSBname[0]) {
+        staged.fields.set(fieldTinyUSBname);
+    }
+    for(uint8_t i = 0; i < 4; i++) {
+        staged.fields.set(fieldProfile + i * profileFieldsCount + profileIrSensitivity);
+        staged.fields.set(fieldProfile + i * profileFieldsCount + profileRunMode);
+    }
+    staged.fields.reset(fieldSelectedProfile);
+    stagedConfigs.Stage(offlineKey, staged);
+    stagedTried.remove(offlineKey);
+    statusBar()->showMessage(QString("Queued for %1; it'll be saved to the gun when it connects.").arg(offlineKey), 5000);
+    StagedWatchUpdate();
+}
+
+
+// Applies whatever was queued offline for the gun that just connected, through the same
+// edit path as the widgets, then commits it like a normal save.
+void guiWindow::StagedApply()
+{
+    const stagedConfig_s *found = stagedConfigs.Find(cacheKey);
+    if(!found || cacheKey.isEmpty()) {
+        return;
+    }
+    stagedConfig_s staged = *found;
+    stagedTried.insert(cacheKey);
+    // A mapping made on another board's layout could name pins this one doesn't have.
+    bool pinsFit = staged.config.bools[customPins] && board.def && board.def->id == staged.boardId;
+    for(uint8_t field = 0; field < fieldsCount; field++) {
+        // Calibration can't be written, only redone on the gun.
+        if(!staged.fields[field] || (!configSchema[field].group && configSchema[field].kind != fieldKindBoard)) {
+            continue;
+        }
+        if(configSchema[field].kind == fieldKindPin) {
+            if(pinsFit) {
+                ApplyField(field, FieldStored(staged.config, field));
+            }
+        } else if(configSchema[field].kind == fieldKindText) {
+            FieldSetString(gunConfig, field, FieldString(staged.config, field));
+            FieldDirty(field, FieldDiffers(field));
+        } else {
+            ApplyField(field, FieldStored(staged.config, field));
+        }
+    }
+
+    if(!dirtyFields.any()) {
+        stagedConfigs.Remove(cacheKey);
+        statusBar()->showMessage("This gun already has the config queued for it.", 5000);
+    } else if(CommitSettings()) {
+        stagedConfigs.Remove(cacheKey);
+        statusBar()->showMessage(QString("Saved the config queued for %1.").arg(cacheKey), 10000);
+    }
+    if(staged.config.bools[customPins] && !pinsFit) {
+        PopupWindow("Pin mapping not applied!", QString("The queued config's pin mapping was made for another board (%1), so this gun kept its own.").arg(staged.boardId), "Heads up", 2);
+    }
+    StagedWatchUpdate();
+}
+
+
+// Connects to the first gun with a queued config that shows up, so staged configs get applied
+// as each gun is plugged in. Guns that were already tried this session are left to the user,
+// so a failing one doesn't get reconnected over and over.
+void guiWindow::StagedWatch()
+{
+    if(serialPort.isOpen() || serialActive || !offlineKey.isEmpty() || update.stage != updateIdle) {
+        return;
+    }
+    const QList<QSerialPortInfo> ports = QSerialPortInfo::availablePorts();
+    for(const QSerialPortInfo &port : ports) {
+        QString key = "usb:" + port.serialNumber();
+        if(port.serialNumber().isEmpty() || !stagedConfigs.Find(key) || stagedTried.contains(key)) {
+            continue;
+        }
+        // Once per gun, even if it turns out we can't connect to it.
+        stagedTried.insert(key);
+        PortsSearch();
+        for(int i = 1; i < ui->comPortSelector->count(); i++) {
+            QVariant data = ui->comPortSelector->itemData(i);
+            if(data.isValid() && serialFoundList[data.toInt()].serialNumber() == port.serialNumber()) {
+                ui->comPortSelector->setCurrentIndex(i);
+                return;
+            }
         }
     }
+}
+
 
+void guiWindow::StagedWatchUpdate()
+{
+    if(stagedConfigs.IsEmpty()) {
+        stagedWatch->stop();
+    } else if(!stagedWatch->isActive()) {
+        stagedWatch->start();
+    }
+}
+
+
+void guiWindow::pinBoxes_activated(uint8_t pin, int index)
+{
+    pinMap_s before = gunConfig.pins;
+    uint32_t wanted = gunConfig.pins.mappedInputs;
     if(!index) {
-        inputsMap[currentPins.value(pin) - 1] = -1;
-        currentPins[pin] = btnUnmapped;
-    } else if(pinBoxesOldIndex[pin] != index) {
-        int8_t btnRequest = index - 1;
-
-        // Scorched Earth approach, clear anything that matches to unmapped.
-        inputsMap[btnRequest] = -1;
-        // only reset if current pin was already mapped.
-        if(currentPins.value(pin) > 0) {
-            inputsMap[currentPins.value(pin) - 1] = -1;
+        // Explicitly unmapped, so whatever was here isn't wanted anymore.
+        if(gunConfig.pins.pinInput[pin] > btnUnmapped) {
+            wanted &= ~(1u << (gunConfig.pins.pinInput[pin] - 1));
+        }
+        gunConfig.pins.UnassignPin(pin);
+    } else if(gunConfig.pins.pinInput[pin] != index) {
+        // Shouldn't be reachable through the combo contents, but a board file could disagree.
+        if(!pinCaps.Fits(pin, index)) {
+            pinBoxes[pin]->setCurrentIndex(gunConfig.pins.pinInput[pin] > btnUnmapped ? gunConfig.pins.pinInput[pin] : btnUnmapped);
+            statusBar()->showMessage(QString("%1 can't be placed on GPIO%2.").arg(valuesNameList[index]).arg(pin), 3000);
+            return;
         }
-        QList<uint8_t> foundList = currentPins.keys(index);
-        for(uint8_t i = 0; i < foundList.length(); i++) {
-            currentPins[foundList[i]] = btnUnmapped;
-            pinBoxes[foundList[i]]->setCurrentIndex(btnUnmapped);
-            pinBoxesOldIndex[foundList[i]] = btnUnmapped;
+        // Only one pin can hold a given input, so clear wherever it was before.
+        int8_t displaced = gunConfig.pins.Assign(pin, index);
+        if(displaced >= 0) {
+            pinBoxes[displaced]->setCurrentIndex(btnUnmapped);
         }
-        // Then map the thing.
-        currentPins[pin] = index;
-        inputsMap[btnRequest] = pin;
+        wanted |= 1u << (index - 1);
     }
-    // because "->currentIndex" is already updated, we just update it at the end of activations
-    // to check that we aren't re-selecting the index for that box.
-    pinBoxesOldIndex[pin] = index;
-    DiffUpdate();
+    // What the user picks by hand stays put from now on.
+    pinsLocked |= 1u << pin;
+    if(autoPinsBtn->isChecked()) {
+        // Anything bumped off this pin gets a new home instead of being dropped.
+        PinsSolve(wanted, gunConfig.pins);
+    } else {
+        boardView->SetMapping(gunConfig.pins);
+    }
+    // One pick can move several inputs; they're undone together.
+    history.BeginGroup();
+    PinsChanged(before);
+    history.EndGroup();
 }
 
 void guiWindow::irBoxes_activated(int index)
@@ -1498,10 +1873,9 @@ void guiWindow::irBoxes_activated(int index)
     }
 
     if(index != irSensOldIndex[slot]) {
-        profilesTable[slot].irSensitivity = index;
+        SetProfileField(slot, profileIrSensitivity, index);
     }
     irSensOldIndex[slot] = index;
-    DiffUpdate();
 }
 
 
@@ -1518,118 +1892,77 @@ void guiWindow::runModeBoxes_activated(int index)
     }
 
     if(index != runModeOldIndex[slot]) {
-        profilesTable[slot].runMode = index;
-    }
-    runModeOldIndex[slot] = index;
-    DiffUpdate();
-}
-
-
-// void guiWindow::on_customPinsEnabled_stateChanged(int arg1)
-// {
-//     boolSettings[customPins] = arg1;
-//     BoxesUpdate();
-//     DiffUpdate();
-// }
-
-void guiWindow::on_nunChuckToggle_stateChanged(int arg1)
-{
-    // Update the boolSettings array for nunChuck
-    boolSettings[nunChuck] = arg1;
-
-    // Send serial command
-    QByteArray command = (arg1 == Qt::Checked) ? "NUNCHUCK\n" : "JOYSTICK\n";  // Add a newline if needed
-    qint64 bytesWritten = serialPort.write(command);
-
-    // Debugging output
-    if (bytesWritten > 0) {
-        qDebug() << "NunChuck support is now:" << command.trimmed();
-    } else {
-        qWarning() << "Failed to send command to serial port.";
-    }
-
-    // Sync changes or trigger further updates
-    DiffUpdate();
-}
-
-
-
-void guiWindow::on_rumbleToggle_stateChanged(int arg1)
-{
-    boolSettings[rumble] = arg1;
-    DiffUpdate();
-}
-
-
-void guiWindow::on_solenoidToggle_stateChanged(int arg1)
-{
-    boolSettings[solenoid] = arg1;
-    DiffUpdate();
-}
-
-
-void guiWindow::on_autofireToggle_stateChanged(int arg1)
-{
-    boolSettings[autofire] = arg1;
-    DiffUpdate();
-}
-
-
-void guiWindow::on_holdToPauseToggle_stateChanged(int arg1)
-{
-    boolSettings[holdToPause] = arg1;
-    DiffUpdate();
-}
-
-
-void guiWindow::on_rumbleIntensityBox_valueChanged(int arg1)
-{
-    settingsTable[rumbleStrength] = arg1;
-    DiffUpdate();
-}
-
-
-void guiWindow::on_rumbleLengthBox_valueChanged(int arg1)
-{
-    settingsTable[rumbleInterval] = arg1;
-    DiffUpdate();
-}
-
-
-void guiWindow::on_holdToPauseLengthBox_valueChanged(int arg1)
-{
-    settingsTable[holdToPauseLength] = arg1;
-    DiffUpdate();
+        SetProfileField(slot, profileRunMode, index);
+    }
+    runModeOldIndex[slot] = index;
 }
 
 
-void guiWindow::on_solenoidNormalIntervalBox_valueChanged(int arg1)
+void guiWindow::customPinsToggle_stateChanged(int arg1)
 {
-    settingsTable[solenoidNormalInterval] = arg1;
-    DiffUpdate();
+    bool wasCustom = gunConfig.bools[customPins];
+    pinMap_s before = gunConfig.pins;
+    gunConfig.bools[customPins] = arg1;
+    BoxesUpdate();
+    // A board that never had custom pins has nothing to start from, so begin at its default wiring.
+    if(gunConfig.bools[customPins] && !gunConfig.pins.mappedInputs) {
+        gunConfig.pins.LoadLayout(BoardLayout());
+        BoxesSync();
+    }
+    autoPinsBtn->setEnabled(gunConfig.bools[customPins]);
+    if(!gunConfig.bools[customPins]) {
+        autoPinsBtn->setChecked(false);
+    }
+    // Pins first, so undoing re-toggles custom pins before putting the old mapping back over it.
+    history.BeginGroup();
+    PinsChanged(before);
+    FieldEdited(fieldBool + customPins, wasCustom, gunConfig.bools[customPins]);
+    history.EndGroup();
+    FieldDirty(fieldBool + customPins, gunConfig_orig.bools[customPins] != gunConfig.bools[customPins]);
+    PinsDirtyRecheck();
 }
 
 
-void guiWindow::on_solenoidFastIntervalBox_valueChanged(int arg1)
+void guiWindow::autoPinsBtn_toggled(bool checked)
 {
-    settingsTable[solenoidFastInterval] = arg1;
-    DiffUpdate();
+    if(!checked) {
+        return;
+    }
+    // Everything currently mapped plus everything the board maps by default,
+    // where possible on the pin it's on now, else on its default pin.
+    pinMap_s defaults;
+    defaults.LoadLayout(BoardLayout());
+    pinMap_s hint = defaults;
+    for(uint8_t i = 0; i < INPUTS_COUNT; i++) {
+        if(gunConfig.pins.inputPin[i] >= 0) {
+            hint.inputPin[i] = gunConfig.pins.inputPin[i];
+        }
+    }
+    pinMap_s before = gunConfig.pins;
+    PinsSolve(gunConfig.pins.mappedInputs | defaults.mappedInputs, hint);
+    history.BeginGroup();
+    PinsChanged(before);
+    history.EndGroup();
 }
 
-
-void guiWindow::on_solenoidHoldLengthBox_valueChanged(int arg1)
+void guiWindow::on_nunChuckToggle_stateChanged(int arg1)
 {
-    settingsTable[solenoidHoldLength] = arg1;
-    DiffUpdate();
-}
+    // Update the boolSettings array for nunChuck
+    SetBool(nunChuck, arg1);
 
+    // Send serial command
+    QByteArray command = (arg1 == Qt::Checked) ? "NUNCHUCK\n" : "JOYSTICK\n";  // Add a newline if needed
+    qint64 bytesWritten = serialPort.write(command);
 
-void guiWindow::on_autofireWaitFactorBox_valueChanged(int arg1)
-{
-    settingsTable[autofireWaitFactor] = arg1;
-    DiffUpdate();
+    // Debugging output
+    if (bytesWritten > 0) {
+        qDebug() << "NunChuck support is now:" << command.trimmed();
+    } else {
+        qWarning() << "Failed to send command to serial port.";
+    }
 }
 
+
 void guiWindow::selectedProfile_isChecked(bool isChecked)
 {
     // apparently we get two signals at once? So just filter for the on.
@@ -1645,8 +1978,7 @@ void guiWindow::selectedProfile_isChecked(bool isChecked)
         }
         if(slot != board.selectedProfile) {
             serialPort.write(QString("XC%1").arg(slot+1).toLocal8Bit());
-            board.selectedProfile = slot;
-            DiffUpdate();
+            SetSelectedProfile(slot);
         }
     }
 }
@@ -1656,29 +1988,7 @@ void guiWindow::on_calib1Btn_clicked()
 {
     serialPort.write("XC1C");
     if (serialPort.waitForBytesWritten(1000)) {
-        QLabel *imageLabel = new QLabel(this); // Create QLabel to hold the image
-        QPixmap pixmap(":/images/Calibration.png"); // Load the image
-
-        // Scale the image to the size of the window or screen
-        pixmap = pixmap.scaled(this->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-        imageLabel->setPixmap(pixmap); // Set the scaled image to the label
-        imageLabel->setAlignment(Qt::AlignCenter); // Center the image in the label
-        imageLabel->setGeometry(0, 0, this->width(), this->height()); // Set label to cover the entire window
-
-        // Create the close button
-        QPushButton *closeButton = new QPushButton("Close", this);
-        closeButton->setGeometry(this->width() - 100, this->height() - 50, 80, 40); // Position the button in the bottom right corner
-        closeButton->setStyleSheet("font-size: 14px; background-color: red; color: white;"); // Optional styling
-
-        // Connect the close button click to close the image window
-        connect(closeButton, &QPushButton::clicked, [imageLabel, closeButton]() {
-            imageLabel->close(); // Close the image window
-            closeButton->close(); // Close the close button
-        });
-
-        imageLabel->show(); // Show the label containing the image
-        closeButton->show(); // Show the close button
+        imageOverlay->ShowImage(":/images/Calibration.png");
     }
 }
 
@@ -1688,29 +1998,7 @@ void guiWindow::on_calib2Btn_clicked()
 {
     serialPort.write("XC1C");
     if (serialPort.waitForBytesWritten(1000)) {
-        QLabel *imageLabel = new QLabel(this); // Create QLabel to hold the image
-        QPixmap pixmap(":/images/Calibration.png"); // Load the image
-
-        // Scale the image to the size of the window or screen
-        pixmap = pixmap.scaled(this->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-        imageLabel->setPixmap(pixmap); // Set the scaled image to the label
-        imageLabel->setAlignment(Qt::AlignCenter); // Center the image in the label
-        imageLabel->setGeometry(0, 0, this->width(), this->height()); // Set label to cover the entire window
-
-        // Create the close button
-        QPushButton *closeButton = new QPushButton("Close", this);
-        closeButton->setGeometry(this->width() - 100, this->height() - 50, 80, 40); // Position the button in the bottom right corner
-        closeButton->setStyleSheet("font-size: 14px; background-color: red; color: white;"); // Optional styling
-
-        // Connect the close button click to close the image window
-        connect(closeButton, &QPushButton::clicked, [imageLabel, closeButton]() {
-            imageLabel->close(); // Close the image window
-            closeButton->close(); // Close the close button
-        });
-
-        imageLabel->show(); // Show the label containing the image
-        closeButton->show(); // Show the close button
+        imageOverlay->ShowImage(":/images/Calibration.png");
     }
 }
 
@@ -1719,29 +2007,7 @@ void guiWindow::on_calib3Btn_clicked()
 {
     serialPort.write("XC1C");
     if (serialPort.waitForBytesWritten(1000)) {
-        QLabel *imageLabel = new QLabel(this); // Create QLabel to hold the image
-        QPixmap pixmap(":/images/icons/Calibrate3.png"); // Load the image
-
-        // Scale the image to the size of the window or screen
-        pixmap = pixmap.scaled(this->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-        imageLabel->setPixmap(pixmap); // Set the scaled image to the label
-        imageLabel->setAlignment(Qt::AlignCenter); // Center the image in the label
-        imageLabel->setGeometry(0, 0, this->width(), this->height()); // Set label to cover the entire window
-
-        // Create the close button
-        QPushButton *closeButton = new QPushButton("Close", this);
-        closeButton->setGeometry(this->width() - 100, this->height() - 50, 80, 40); // Position the button in the bottom right corner
-        closeButton->setStyleSheet("font-size: 14px; background-color: red; color: white;"); // Optional styling
-
-        // Connect the close button click to close the image window
-        connect(closeButton, &QPushButton::clicked, [imageLabel, closeButton]() {
-            imageLabel->close(); // Close the image window
-            closeButton->close(); // Close the close button
-        });
-
-        imageLabel->show(); // Show the label containing the image
-        closeButton->show(); // Show the close button
+        imageOverlay->ShowImage(":/images/Calibration.png");
     }
 }
 
@@ -1750,34 +2016,24 @@ void guiWindow::on_calib4Btn_clicked()
 {
     serialPort.write("XC1C");
     if (serialPort.waitForBytesWritten(1000)) {
-        QLabel *imageLabel = new QLabel(this); // Create QLabel to hold the image
-        QPixmap pixmap(":/images/icons/Calibrate4.png"); // Load the image
-
-        // Scale the image to the size of the window or screen
-        pixmap = pixmap.scaled(this->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-        imageLabel->setPixmap(pixmap); // Set the scaled image to the label
-        imageLabel->setAlignment(Qt::AlignCenter); // Center the image in the label
-        imageLabel->setGeometry(0, 0, this->width(), this->height()); // Set label to cover the entire window
-
-        // Create the close button
-        QPushButton *closeButton = new QPushButton("Close", this);
-        closeButton->setGeometry(this->width() - 100, this->height() - 50, 80, 40); // Position the button in the bottom right corner
-        closeButton->setStyleSheet("font-size: 14px; background-color: red; color: white;"); // Optional styling
+        imageOverlay->ShowImage(":/images/Calibration.png");
+    }
+}
 
-        // Connect the close button click to close the image window
-        connect(closeButton, &QPushButton::clicked, [imageLabel, closeButton]() {
-            imageLabel->close(); // Close the image window
-            closeButton->close(); // Close the close button
-        });
 
-        imageLabel->show(); // Show the label containing the image
-        closeButton->show(); // Show the close button
+// WARNING: make sure "serialActive" is set ON for important operations, or this will eat the fucker
+// Button tester image at the 115x115 it's drawn at. Baked builds already have it at that size;
+// cross-builds without the baker get the source image, scaled here instead.
+static QPixmap ButtonPixmap(const QString &path)
+{
+    QPixmap pixmap(path);
+    if(pixmap.width() > 115 || pixmap.height() > 115) {
+        pixmap = pixmap.scaled(115, 115, Qt::KeepAspectRatio, Qt::SmoothTransformation);
     }
+    return pixmap;
 }
 
 
-// WARNING: make sure "serialActive" is set ON for important operations, or this will eat the fucker
 void guiWindow::serialPort_readyRead()
 {
     if(!serialActive) {
@@ -1787,17 +2043,12 @@ void guiWindow::serialPort_readyRead()
                 idleBuffer = idleBuffer.right(4);
                 idleBuffer = idleBuffer.trimmed();
                 uint8_t button = idleBuffer.toInt();
+                boardView->SetInputActive(button, true);
                 switch(button) {
                 case btnTrigger:
                     if (!isButtonPressed) {
-                        // Load the "clicked" image
-                        QPixmap clickedPixmap(":/images/icons/Trigger-Clicked.png");
-
-                        // Scale the pixmap to 115x115
-                        clickedPixmap = clickedPixmap.scaled(115, 115, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-                        // Set the pixmap to the label
-                        ui->btnTriggerLabel->setPixmap(clickedPixmap);
+                        // Load the "clicked" image, baked at 115x115
+                        ui->btnTriggerLabel->setPixmap(ButtonPixmap(":/images/icons/Trigger-Clicked.png"));
 
                         // Mark the button as pressed
                         isButtonPressed = true;
@@ -1805,14 +2056,8 @@ void guiWindow::serialPort_readyRead()
                     break;
                 case btnGunA:
                     if (!isButtonPressed) {
-                        // Load the "clicked" image
-                        QPixmap clickedPixmap(":/images/icons/A-Clicked.png");
-
-                        // Scale the pixmap to 115x115
-                        clickedPixmap = clickedPixmap.scaled(115, 115, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-                        // Set the pixmap to the label
-                        ui->btnALabel->setPixmap(clickedPixmap);
+                        // Load the "clicked" image, baked at 115x115
+                        ui->btnALabel->setPixmap(ButtonPixmap(":/images/icons/A-Clicked.png"));
 
                         // Mark the button as pressed
                         isButtonPressed = true;
@@ -1820,14 +2065,8 @@ void guiWindow::serialPort_readyRead()
                     break;
                 case btnGunB:
                     if (!isButtonPressed) {
-                        // Load the "clicked" image
-                        QPixmap clickedPixmap(":/images/icons/B-Clicked.png");
-
-                        // Scale the pixmap to 115x115
-                        clickedPixmap = clickedPixmap.scaled(115, 115, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-                        // Set the pixmap to the label
-                        ui->btnBLabel->setPixmap(clickedPixmap);
+                        // Load the "clicked" image, baked at 115x115
+                        ui->btnBLabel->setPixmap(ButtonPixmap(":/images/icons/B-Clicked.png"));
 
                         // Mark the button as pressed
                         isButtonPressed = true;
@@ -1835,14 +2074,8 @@ void guiWindow::serialPort_readyRead()
                     break;
                 case btnGunC:
                     if (!isButtonPressed) {
-                        // Load the "clicked" image
-                        QPixmap clickedPixmap(":/images/icons/C-Clicked.png");
-
-                        // Scale the pixmap to 115x115
-                        clickedPixmap = clickedPixmap.scaled(115, 115, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-                        // Set the pixmap to the label
-                        ui->btnCLabel->setPixmap(clickedPixmap);
+                        // Load the "clicked" image, baked at 115x115
+                        ui->btnCLabel->setPixmap(ButtonPixmap(":/images/icons/C-Clicked.png"));
 
                         // Mark the button as pressed
                         isButtonPressed = true;
@@ -1850,14 +2083,8 @@ void guiWindow::serialPort_readyRead()
                     break;
                 case btnStart:
                     if (!isButtonPressed) {
-                        // Load the "clicked" image
-                        QPixmap clickedPixmap(":/images/icons/Start-Clicked.png");
-
-                        // Scale the pixmap to 115x115
-                        clickedPixmap = clickedPixmap.scaled(115, 115, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-                        // Set the pixmap to the label
-                        ui->btnStartLabel->setPixmap(clickedPixmap);
+                        // Load the "clicked" image, baked at 115x115
+                        ui->btnStartLabel->setPixmap(ButtonPixmap(":/images/icons/Start-Clicked.png"));
 
                         // Mark the button as pressed
                         isButtonPressed = true;
@@ -1865,14 +2092,8 @@ void guiWindow::serialPort_readyRead()
                     break;
                 case btnSelect:
                     if (!isButtonPressed) {
-                        // Load the "clicked" image
-                        QPixmap clickedPixmap(":/images/icons/Select-Clicked.png");
-
-                        // Scale the pixmap to 115x115
-                        clickedPixmap = clickedPixmap.scaled(115, 115, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-                        // Set the pixmap to the label
-                        ui->btnSelectLabel->setPixmap(clickedPixmap);
+                        // Load the "clicked" image, baked at 115x115
+                        ui->btnSelectLabel->setPixmap(ButtonPixmap(":/images/icons/Select-Clicked.png"));
 
                         // Mark the button as pressed
                         isButtonPressed = true;
@@ -1880,14 +2101,8 @@ void guiWindow::serialPort_readyRead()
                     break;
                 case btnGunUp:
                     if (!isButtonPressed) {
-                        // Load the "clicked" image
-                        QPixmap clickedPixmap(":/images/icons/Up-Clicked.png");
-
-                        // Scale the pixmap to 115x115
-                        clickedPixmap = clickedPixmap.scaled(115, 115, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-                        // Set the pixmap to the label
-                        ui->btnGunUpLabel->setPixmap(clickedPixmap);
+                        // Load the "clicked" image, baked at 115x115
+                        ui->btnGunUpLabel->setPixmap(ButtonPixmap(":/images/icons/Up-Clicked.png"));
 
                         // Mark the button as pressed
                         isButtonPressed = true;
@@ -1895,14 +2110,8 @@ void guiWindow::serialPort_readyRead()
                     break;
                 case btnGunDown:
                     if (!isButtonPressed) {
-                        // Load the "clicked" image
-                        QPixmap clickedPixmap(":/images/icons/Down-Clicked.png");
-
-                        // Scale the pixmap to 115x115
-                        clickedPixmap = clickedPixmap.scaled(115, 115, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-                        // Set the pixmap to the label
-                        ui->btnGunDownLabel->setPixmap(clickedPixmap);
+                        // Load the "clicked" image, baked at 115x115
+                        ui->btnGunDownLabel->setPixmap(ButtonPixmap(":/images/icons/Down-Clicked.png"));
 
                         // Mark the button as pressed
                         isButtonPressed = true;
@@ -1910,14 +2119,8 @@ void guiWindow::serialPort_readyRead()
                     break;
                 case btnGunLeft:
                     if (!isButtonPressed) {
-                        // Load the "clicked" image
-                        QPixmap clickedPixmap(":/images/icons/Left-Clicked.png");
-
-                        // Scale the pixmap to 115x115
-                        clickedPixmap = clickedPixmap.scaled(115, 115, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-                        // Set the pixmap to the label
-                        ui->btnGunLeftLabel->setPixmap(clickedPixmap);
+                        // Load the "clicked" image, baked at 115x115
+                        ui->btnGunLeftLabel->setPixmap(ButtonPixmap(":/images/icons/Left-Clicked.png"));
 
                         // Mark the button as pressed
                         isButtonPressed = true;
@@ -1925,14 +2128,8 @@ void guiWindow::serialPort_readyRead()
                     break;
                 case btnGunRight:
                     if (!isButtonPressed) {
-                        // Load the "clicked" image
-                        QPixmap clickedPixmap(":/images/icons/Right-Clicked.png");
-
-                        // Scale the pixmap to 115x115
-                        clickedPixmap = clickedPixmap.scaled(115, 115, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-                        // Set the pixmap to the label
-                        ui->btnGunRightLabel->setPixmap(clickedPixmap);
+                        // Load the "clicked" image, baked at 115x115
+                        ui->btnGunRightLabel->setPixmap(ButtonPixmap(":/images/icons/Right-Clicked.png"));
 
                         // Mark the button as pressed
                         isButtonPressed = true;
@@ -1940,14 +2137,8 @@ void guiWindow::serialPort_readyRead()
                     break;
                 case btnPedal:
                     if (!isButtonPressed) {
-                        // Load the "clicked" image
-                        QPixmap clickedPixmap(":/images/icons/Pedal-Clicked.png");
-
-                        // Scale the pixmap to 115x115
-                        clickedPixmap = clickedPixmap.scaled(115, 115, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-                        // Set the pixmap to the label
-                        ui->btnPedalLabel->setPixmap(clickedPixmap);
+                        // Load the "clicked" image, baked at 115x115
+                        ui->btnPedalLabel->setPixmap(ButtonPixmap(":/images/icons/Pedal-Clicked.png"));
 
                         // Mark the button as pressed
                         isButtonPressed = true;
@@ -1955,14 +2146,8 @@ void guiWindow::serialPort_readyRead()
                     break;
                 case btnPump:
                     if (!isButtonPressed) {
-                        // Load the "clicked" image
-                        QPixmap clickedPixmap(":/images/icons/Pump-Clicked.png");
-
-                        // Scale the pixmap to 115x115
-                        clickedPixmap = clickedPixmap.scaled(115, 115, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-                        // Set the pixmap to the label
-                        ui->btnPumpLabel->setPixmap(clickedPixmap);
+                        // Load the "clicked" image, baked at 115x115
+                        ui->btnPumpLabel->setPixmap(ButtonPixmap(":/images/icons/Pump-Clicked.png"));
 
                         // Mark the button as pressed
                         isButtonPressed = true;
@@ -1973,18 +2158,12 @@ void guiWindow::serialPort_readyRead()
                 idleBuffer = idleBuffer.right(4);
                 idleBuffer = idleBuffer.trimmed();
                 uint8_t button = idleBuffer.toInt();
+                boardView->SetInputActive(button, false);
                 switch(button) {
                 case btnTrigger:
                     if (isButtonPressed) {
                         // Revert to the "default" image on button release
-                        QPixmap defaultPixmap(":/images/icons/Trigger.png");
-
-
-                        // Use the fixed original size of the label to scale the pixmap
-                        QSize labelSize(115, 115); // Replace with the actual fixed size of the label
-
-                        // Scale the pixmap to fit the fixed label size while keeping the aspect ratio
-                        ui->btnTriggerLabel->setPixmap(defaultPixmap.scaled(labelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+                        ui->btnTriggerLabel->setPixmap(ButtonPixmap(":/images/icons/Trigger.png"));
 
                         // Set the flag to false, indicating the button has been released
                         isButtonPressed = false;
@@ -1993,14 +2172,7 @@ void guiWindow::serialPort_readyRead()
                 case btnGunA:
                     if (isButtonPressed) {
                         // Revert to the "default" image on button release
-                        QPixmap defaultPixmap(":/images/icons/T_A_Key_Vintage.png");
-
-
-                        // Use the fixed original size of the label to scale the pixmap
-                        QSize labelSize(115, 115); // Replace with the actual fixed size of the label
-
-                        // Scale the pixmap to fit the fixed label size while keeping the aspect ratio
-                        ui->btnALabel->setPixmap(defaultPixmap.scaled(labelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+                        ui->btnALabel->setPixmap(ButtonPixmap(":/images/icons/T_A_Key_Vintage.png"));
 
                         // Set the flag to false, indicating the button has been released
                         isButtonPressed = false;
@@ -2009,14 +2181,7 @@ void guiWindow::serialPort_readyRead()
                 case btnGunB:
                     if (isButtonPressed) {
                         // Revert to the "default" image on button release
-                        QPixmap defaultPixmap(":/images/icons/T_B_Key_Vintage.png");
-
-
-                        // Use the fixed original size of the label to scale the pixmap
-                        QSize labelSize(115, 115); // Replace with the actual fixed size of the label
-
-                        // Scale the pixmap to fit the fixed label size while keeping the aspect ratio
-                        ui->btnBLabel->setPixmap(defaultPixmap.scaled(labelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+                        ui->btnBLabel->setPixmap(ButtonPixmap(":/images/icons/T_B_Key_Vintage.png"));
 
                         // Set the flag to false, indicating the button has been released
                         isButtonPressed = false;
@@ -2025,14 +2190,7 @@ void guiWindow::serialPort_readyRead()
                 case btnGunC:
                     if (isButtonPressed) {
                         // Revert to the "default" image on button release
-                        QPixmap defaultPixmap(":/images/icons/T_C_Key_Vintage.png");
-
-
-                        // Use the fixed original size of the label to scale the pixmap
-                        QSize labelSize(115, 115); // Replace with the actual fixed size of the label
-
-                        // Scale the pixmap to fit the fixed label size while keeping the aspect ratio
-                        ui->btnCLabel->setPixmap(defaultPixmap.scaled(labelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+                        ui->btnCLabel->setPixmap(ButtonPixmap(":/images/icons/T_C_Key_Vintage.png"));
 
                         // Set the flag to false, indicating the button has been released
                         isButtonPressed = false;
@@ -2041,14 +2199,7 @@ void guiWindow::serialPort_readyRead()
                 case btnStart:
                     if (isButtonPressed) {
                         // Revert to the "default" image on button release
-                        QPixmap defaultPixmap(":/images/icons/Start.png");
-
-
-                        // Use the fixed original size of the label to scale the pixmap
-                        QSize labelSize(115, 115); // Replace with the actual fixed size of the label
-
-                        // Scale the pixmap to fit the fixed label size while keeping the aspect ratio
-                        ui->btnStartLabel->setPixmap(defaultPixmap.scaled(labelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+                        ui->btnStartLabel->setPixmap(ButtonPixmap(":/images/icons/Start.png"));
 
                         // Set the flag to false, indicating the button has been released
                         isButtonPressed = false;
@@ -2057,14 +2208,7 @@ void guiWindow::serialPort_readyRead()
                 case btnSelect:
                     if (isButtonPressed) {
                         // Revert to the "default" image on button release
-                        QPixmap defaultPixmap(":/images/icons/Select.png");
-
-
-                        // Use the fixed original size of the label to scale the pixmap
-                        QSize labelSize(115, 115); // Replace with the actual fixed size of the label
-
-                        // Scale the pixmap to fit the fixed label size while keeping the aspect ratio
-                        ui->btnSelectLabel->setPixmap(defaultPixmap.scaled(labelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+                        ui->btnSelectLabel->setPixmap(ButtonPixmap(":/images/icons/Select.png"));
 
                         // Set the flag to false, indicating the button has been released
                         isButtonPressed = false;
@@ -2073,14 +2217,7 @@ void guiWindow::serialPort_readyRead()
                 case btnGunUp:
                     if (isButtonPressed) {
                         // Revert to the "default" image on button release
-                        QPixmap defaultPixmap(":/images/icons/T_Up_Key_Vintage.png");
-
-
-                        // Use the fixed original size of the label to scale the pixmap
-                        QSize labelSize(115, 115); // Replace with the actual fixed size of the label
-
-                        // Scale the pixmap to fit the fixed label size while keeping the aspect ratio
-                        ui->btnGunUpLabel->setPixmap(defaultPixmap.scaled(labelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+                        ui->btnGunUpLabel->setPixmap(ButtonPixmap(":/images/icons/T_Up_Key_Vintage.png"));
 
                         // Set the flag to false, indicating the button has been released
                         isButtonPressed = false;
@@ -2089,14 +2226,7 @@ void guiWindow::serialPort_readyRead()
                 case btnGunDown:
                     if (isButtonPressed) {
                         // Revert to the "default" image on button release
-                        QPixmap defaultPixmap(":/images/icons/T_Down_Key_Vintage.png");
-
-
-                        // Use the fixed original size of the label to scale the pixmap
-                        QSize labelSize(115, 115); // Replace with the actual fixed size of the label
-
-                        // Scale the pixmap to fit the fixed label size while keeping the aspect ratio
-                        ui->btnGunDownLabel->setPixmap(defaultPixmap.scaled(labelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+                        ui->btnGunDownLabel->setPixmap(ButtonPixmap(":/images/icons/T_Down_Key_Vintage.png"));
 
                         // Set the flag to false, indicating the button has been released
                         isButtonPressed = false;
@@ -2105,14 +2235,7 @@ void guiWindow::serialPort_readyRead()
                 case btnGunLeft:
                     if (isButtonPressed) {
                         // Revert to the "default" image on button release
-                        QPixmap defaultPixmap(":/images/icons/T_Left_Key_Vintage.png");
-
-
-                        // Use the fixed original size of the label to scale the pixmap
-                        QSize labelSize(115, 115); // Replace with the actual fixed size of the label
-
-                        // Scale the pixmap to fit the fixed label size while keeping the aspect ratio
-                        ui->btnGunLeftLabel->setPixmap(defaultPixmap.scaled(labelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+                        ui->btnGunLeftLabel->setPixmap(ButtonPixmap(":/images/icons/T_Left_Key_Vintage.png"));
 
                         // Set the flag to false, indicating the button has been released
                         isButtonPressed = false;
@@ -2121,14 +2244,7 @@ void guiWindow::serialPort_readyRead()
                 case btnGunRight:
                     if (isButtonPressed) {
                         // Revert to the "default" image on button release
-                        QPixmap defaultPixmap(":/images/icons/T_Right_Key_Vintage.png");
-
-
-                        // Use the fixed original size of the label to scale the pixmap
-                        QSize labelSize(115, 115); // Replace with the actual fixed size of the label
-
-                        // Scale the pixmap to fit the fixed label size while keeping the aspect ratio
-                        ui->btnGunRightLabel->setPixmap(defaultPixmap.scaled(labelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+                        ui->btnGunRightLabel->setPixmap(ButtonPixmap(":/images/icons/T_Right_Key_Vintage.png"));
 
                         // Set the flag to false, indicating the button has been released
                         isButtonPressed = false;
@@ -2137,14 +2253,7 @@ void guiWindow::serialPort_readyRead()
                 case btnPedal:
                     if (isButtonPressed) {
                         // Revert to the "default" image on button release
-                        QPixmap defaultPixmap(":/images/icons/Pedal.png");
-
-
-                        // Use the fixed original size of the label to scale the pixmap
-                        QSize labelSize(115, 115); // Replace with the actual fixed size of the label
-
-                        // Scale the pixmap to fit the fixed label size while keeping the aspect ratio
-                        ui->btnPedalLabel->setPixmap(defaultPixmap.scaled(labelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+                        ui->btnPedalLabel->setPixmap(ButtonPixmap(":/images/icons/Pedal.png"));
 
                         // Set the flag to false, indicating the button has been released
                         isButtonPressed = false;
@@ -2153,14 +2262,7 @@ void guiWindow::serialPort_readyRead()
                 case btnPump:
                     if (isButtonPressed) {
                         // Revert to the "default" image on button release
-                        QPixmap defaultPixmap(":/images/icons/Pump.png");
-
-
-                        // Use the fixed original size of the label to scale the pixmap
-                        QSize labelSize(115, 115); // Replace with the actual fixed size of the label
-
-                        // Scale the pixmap to fit the fixed label size while keeping the aspect ratio
-                        ui->btnPumpLabel->setPixmap(defaultPixmap.scaled(labelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+                        ui->btnPumpLabel->setPixmap(ButtonPixmap(":/images/icons/Pump.png"));
 
                         // Set the flag to false, indicating the button has been released
                         isButtonPressed = false;
@@ -2172,10 +2274,9 @@ void guiWindow::serialPort_readyRead()
                 idleBuffer = idleBuffer.trimmed();
                 uint8_t selection = idleBuffer.toInt();
                 if(selection != board.selectedProfile) {
-                    board.selectedProfile = selection;
+                    SetSelectedProfile(selection);
                     selectedProfile[selection]->setChecked(true);
                 }
-                DiffUpdate();
             } else if(idleBuffer.contains("UpdatedProf: ")) {
                 idleBuffer = idleBuffer.right(3);
                 idleBuffer = idleBuffer.trimmed();
@@ -2183,20 +2284,19 @@ void guiWindow::serialPort_readyRead()
                 if(selection != board.selectedProfile) {
                     selectedProfile[selection]->setChecked(true);
                 }
-                board.selectedProfile = selection;
+                SetSelectedProfile(selection);
                 idleBuffer = serialPort.readLine();
                 xScale[selection]->setText(idleBuffer.trimmed());
-                profilesTable[selection].xScale = xScale[selection]->text().toInt();
+                SetProfileField(selection, profileXScale, xScale[selection]->text().toInt());
                 idleBuffer = serialPort.readLine();
                 yScale[selection]->setText(idleBuffer.trimmed());
-                profilesTable[selection].yScale = yScale[selection]->text().toInt();
+                SetProfileField(selection, profileYScale, yScale[selection]->text().toInt());
                 idleBuffer = serialPort.readLine();
                 xCenter[selection]->setText(idleBuffer.trimmed());
-                profilesTable[selection].xCenter = xCenter[selection]->text().toInt();
+                SetProfileField(selection, profileXCenter, xCenter[selection]->text().toInt());
                 idleBuffer = serialPort.readLine();
                 yCenter[selection]->setText(idleBuffer.trimmed());
-                profilesTable[selection].yCenter = yCenter[selection]->text().toInt();
-                DiffUpdate();
+                SetProfileField(selection, profileYCenter, yCenter[selection]->text().toInt());
             }
         }
     } else if(testMode) {
@@ -2257,7 +2357,7 @@ void guiWindow::on_testBtn_clicked()
             ui->testBtn->setText("Disable IR Test Mode");
             ui->confirmButton->setEnabled(false);
             ui->confirmButton->setText("[Disabled while in Test Mode]");
-            // ui->pinsTab->setEnabled(false);
+            pinsTab->setEnabled(false);
             ui->settingsTab->setEnabled(false);
             ui->profilesTab->setEnabled(false);
             ui->feedbackTestsBox->setEnabled(false);
@@ -2267,7 +2367,7 @@ void guiWindow::on_testBtn_clicked()
             ui->testView->setEnabled(false);
             ui->buttonsTestArea->setEnabled(true);
             ui->testBtn->setText("Enable IR Test Mode");
-            // ui->pinsTab->setEnabled(true);
+            pinsTab->setEnabled(true);
             ui->settingsTab->setEnabled(true);
             ui->profilesTab->setEnabled(true);
             ui->feedbackTestsBox->setEnabled(true);
@@ -2301,6 +2401,7 @@ void guiWindow::on_clearEepromBtn_new_clicked()
             if(serialPort.waitForReadyRead(5000)) {
                 QString buffer = serialPort.readLine();
                 if(buffer.trimmed() == "Cleared! Please reset the board.") {
+                    configCache.Forget(cacheKey);
                     serialPort.write("XE");
                     serialPort.waitForBytesWritten(2000);
                     serialPort.close();
@@ -2319,80 +2420,78 @@ void guiWindow::on_clearEepromBtn_new_clicked()
 
 void guiWindow::on_baudResetBtn_clicked()
 {
-    // TODO: Does not work for now, for some reason.
-    // Seems to be a QT bug? This is nearly identical to Earle's code.
+    QVariant port = ui->comPortSelector->itemData(ui->comPortSelector->currentIndex());
+    if(!port.isValid()) {
+        return;
+    }
     qDebug() << "Sending reset command.";
     serialActive = true;
     serialPort.close();
-// DIRTY HACK: just directly call OS-level apps to do this for us.
-#ifdef Q_OS_UNIX
-    // stty does this in a neat one-liner and is standard on *nixes
-    QProcess *externalProg = new QProcess;
-    QStringList args;
-    args << "-F" << QString("%1").arg(serialFoundList[ui->comPortSelector->currentIndex()-1].systemLocation()) << "1200";
-    externalProg->start("/usr/bin/stty", args);
-    // At least on my system, the Bootloader device takes ~7s to appear
-    QThread::msleep(7000);
-    // Class-ify this function, maybe.
-    QString picoPath;
-    foreach(const QStorageInfo &storageDevices, QStorageInfo::mountedVolumes()) {
-        if(storageDevices.isValid() && storageDevices.isReady() && storageDevices.displayName() == "RPI-RP2") {
-            picoPath = storageDevices.device();
-            qDebug() << "Found a Pico bootloader!";
-            break;
-        } else {
-            qDebug() << "nope";
-        }
+    // The drive can take several seconds to appear and mount; BootloaderFound picks it up from here.
+    if(bootloaderWatcher->Reset(serialFoundList[port.toInt()])) {
+        ui->statusBar->showMessage("Resetting board to its bootloader...");
+    } else {
+        PopupWindow("Couldn't reset the board!", "The gun's serial port couldn't be opened to send the bootloader reset.\nMake sure nothing else is using it and try again.", "Oops!", 3);
     }
-    qDebug() << picoPath;
-// QFile::copy("file", picoPath+"file");
-#endif
-#ifdef Q_OS_WIN
-    qDebug()<<"WINDOWS";
-    // Ooooh, Windows as a mode option that does basically the same!
-    QProcess *externalProg = new QProcess;
-    QStringList args;
-    // args << QString("%1").arg(serialFoundList[ui->comPortSelector->currentIndex()-1].portName()) << "baud=12" << "parity=n" << "data=8" << "stop=1" << "dtr=off";
-    // externalProg->start("mode", args);
-    QString comPort = serialFoundList[ui->comPortSelector->currentIndex() - 1].portName();
-    args << "/C" << "mode" << comPort << "baud=1200" << "parity=n" << "data=8" << "stop=1" << "dtr=off";
-
-    externalProg->start("cmd.exe", args);
-
-    if (!externalProg->waitForStarted()) {
-        qDebug() << "Failed to start cmd.exe";
-        return;
+    ui->comPortSelector->setCurrentIndex(0);
+    serialActive = false;
+}
+
+
+void guiWindow::BootloaderPortGone(qint64 elapsedMs)
+{
+    if(update.stage == updateReset) {
+        UpdateStage(updateDrive);
     }
+    ui->statusBar->showMessage(QString("Board reset after %1 ms, waiting for its bootloader drive...").arg(elapsedMs));
+}
+
 
-    if (!externalProg->waitForFinished()) {
-        qDebug() << "Failed to finish cmd.exe";
+void guiWindow::BootloaderResetFailed()
+{
+    ui->statusBar->clearMessage();
+    if(update.stage != updateIdle) {
+        UpdateFinish(false, "The gun didn't reset to its bootloader.");
+        return;
     }
+    PopupWindow("Board didn't reset!", "The gun is still connected as a serial device after the bootloader reset.\n\nTry again, or hold BOOTSEL while plugging it in.", "Oops!", 3);
+}
 
-    QString output = externalProg->readAllStandardOutput();
-    QString errorOutput = externalProg->readAllStandardError();
 
-    qDebug() << "Output: " << output;
-    qDebug() << "Error Output: " << errorOutput;
+void guiWindow::BootloaderFound(const QString &mountPath, qint64 elapsedMs)
+{
+    if(update.stage == updateDrive) {
+        UpdateStage(updateFlash);
+        if(!flasher->Start(update.image, mountPath, QString("Player%1.uf2").arg(update.player + 1))) {
+            UpdateFinish(false, flasher->Error());
+            return;
+        }
+        ui->pbTransfer->setEnabled(false);
+        flashProgress = new QProgressBar();
+        flashProgress->setRange(0, update.image.Data().size());
+        ui->statusBar->addPermanentWidget(flashProgress);
+        ui->statusBar->showMessage(QString("Updating Player %1: flashing...").arg(update.player + 1));
+        return;
+    }
+    on_pbRefreshDev_clicked();
+    int index = ui->cbUsbDev->findData(mountPath);
+    if(index < 0) {
+        ui->cbUsbDev->addItem(QString(BOOTLOADER_LABEL " (%1)").arg(mountPath), mountPath);
+        index = ui->cbUsbDev->count() - 1;
+    }
+    ui->cbUsbDev->setCurrentIndex(index);
+    ui->statusBar->showMessage(QString("Bootloader ready at %1 after %2 ms; pick a player and flash.").arg(mountPath).arg(elapsedMs), 10000);
+}
 
-    externalProg->close();
 
-#else
-// The builtin method that currently does not work at all atm. Let's hope to use this soon.
-// serialPort.setDataTerminalReady(false);
-// qDebug() << serialPort.isDataTerminalReady();
-// QThread::msleep(100);
-// serialPort.setBaudRate(QSerialPort::Baud1200);
-// qDebug() << serialPort.baudRate();
-// QThread::msleep(100);
-// serialPort.close();
-// QThread::msleep(100);
-// qDebug() << serialPort.baudRate();
-// qDebug() << serialPort.isDataTerminalReady();
-// serialPort.open(QIODevice::ReadOnly);
-#endif
-    ui->statusBar->showMessage("Board reset to bootloader.", 5000);
-    ui->comPortSelector->setCurrentIndex(0);
-    serialActive = false;
+void guiWindow::BootloaderTimedOut(qint64 elapsedMs)
+{
+    ui->statusBar->clearMessage();
+    if(update.stage != updateIdle) {
+        UpdateFinish(false, QString("No bootloader drive showed up within %1 seconds.").arg(elapsedMs / 1000));
+        return;
+    }
+    PopupWindow("Bootloader not found!", QString("No RPI-RP2 drive showed up within %1 seconds.\n\nIf the gun did reset, its drive may need mounting by hand; then use \"Refresh devices\".").arg(elapsedMs / 1000), "Oops!", 3);
 }
 
 void guiWindow::on_actionAbout_IR_PIGS_triggered()
@@ -2404,32 +2503,318 @@ void guiWindow::on_actionAbout_IR_PIGS_triggered()
 }
 
 
+// Board to pick firmware for: the last gun that identified itself, else the one all releases so far are for.
+static QString FlashBoard()
+{
+    return board.def ? board.def->id : FIRMWARE_DEFAULT_BOARD;
+}
+
+
+// Player's (0-based) firmware of the given version for FlashBoard(), verified against the catalog.
+static bool PlayerImage(const QString &version, int player, Uf2Image &image, QString &error)
+{
+    const firmwareEntry_s *entry = firmwareCatalog.Find(FlashBoard(), version, player);
+    if(!entry) {
+        error = QString("There's no %1 firmware for Player %2 on this board (%3).")
+                .arg(version.isEmpty() ? "local" : "v" + version).arg(player + 1).arg(FlashBoard());
+        return false;
+    }
+    if(!firmwareCatalog.Image(*entry, image)) {
+        error = firmwareCatalog.Error();
+        return false;
+    }
+    return true;
+}
+
+
 void guiWindow::on_pbTransfer_clicked()
 {
     // on_baudResetBtn_clicked();
+    if(flasher->IsBusy()) {
+        return;
+    }
     QString selectedDrive = ui->cbUsbDev->itemData(ui->cbUsbDev->currentIndex()).toString();
+    if(selectedDrive.isEmpty()) {
+        PopupWindow("No drive selected!", "Reboot the gun to its bootloader, then pick its drive (RPI-RP2) from the list.", "Oops!", 3);
+        return;
+    }
+
+    flashPlayer = ui->cbPlayer->currentIndex();
+    QString fileName = "Player" + QString::number(flashPlayer + 1) + ".uf2";
+    // Checked up front, so a bad file never gets partway onto a gun.
+    Uf2Image image;
+    QString error;
+    if(!PlayerImage(fwVersionBox->currentData().toString(), flashPlayer, image, error)) {
+        QMessageBox::critical(this, tr("Error"), error);
+        return;
+    }
+    qDebug() << fileName << image.BlockCount() << "blocks for" << QString::number(image.AddressLow(), 16) << "-" << QString::number(image.AddressHigh(), 16);
+    if(!flasher->Start(image, selectedDrive, fileName)) {
+        QMessageBox::critical(this, tr("Error"), flasher->Error());
+        return;
+    }
+
+    ui->pbTransfer->setEnabled(false);
+    flashProgress = new QProgressBar();
+    flashProgress->setRange(0, image.Data().size());
+    ui->statusBar->addPermanentWidget(flashProgress);
+    ui->statusBar->showMessage(QString("Flashing %1...").arg(fileName));
+}
+
+
+void guiWindow::FlashProgress(qint64 written, qint64 total)
+{
+    if(flashProgress) {
+        flashProgress->setValue(written);
+        flashProgress->setFormat(QString("%1 / %2 KB").arg(written / 1024).arg(total / 1024));
+    }
+}
+
+
+void guiWindow::FlashFinished(bool ok, qint64 elapsedMs)
+{
+    ui->statusBar->removeWidget(flashProgress);
+    delete flashProgress;
+    flashProgress = nullptr;
+    ui->pbTransfer->setEnabled(true);
+    if(!ok) {
+        ui->statusBar->clearMessage();
+        if(update.stage != updateIdle) {
+            UpdateFinish(false, flasher->Error());
+        } else {
+            QMessageBox::critical(this, tr("Error"), flasher->Error());
+        }
+        return;
+    }
+    if(update.stage == updateFlash) {
+        UpdateStage(updateReconnect);
+    }
+    if(flasher->Verification() == uf2VerifyPassed) {
+        ui->statusBar->showMessage(QString("Flashed and read back OK in %1 ms, waiting for the gun to come back...").arg(elapsedMs));
+    } else {
+        ui->statusBar->showMessage(QString("Flashed in %1 ms (unverified, nothing to read back), waiting for the gun to come back...").arg(elapsedMs));
+    }
+    flashReconnectTicks = 0;
+    flashReconnect->start();
+}
+
+
+// Looks for the freshly flashed gun's serial port, and connects to it once it shows up.
+void guiWindow::FlashReconnect()
+{
+    const QList<QSerialPortInfo> ports = QSerialPortInfo::availablePorts();
+    for(const QSerialPortInfo &port : ports) {
+        if(QPair<int, int>(port.vendorIdentifier(), port.productIdentifier()) != playerUsbIds[flashPlayer]) {
+            continue;
+        }
+        // An update waits for its own gun, not just any gun in the same player slot.
+        if(update.stage != updateIdle && update.key.startsWith("usb:") && "usb:" + port.serialNumber() != update.key) {
+            continue;
+        }
+        flashReconnect->stop();
+        PortsSearch();
+        for(int i = 1; i < ui->comPortSelector->count(); i++) {
+            QVariant data = ui->comPortSelector->itemData(i);
+            if(data.isValid() && serialFoundList[data.toInt()].systemLocation() == port.systemLocation()) {
+                ui->statusBar->showMessage(QString("Flashed and reconnected to Player %1.").arg(flashPlayer + 1), 5000);
+                ui->comPortSelector->setCurrentIndex(i);
+                if(update.stage != updateIdle) {
+                    UpdateFinish(update.stage == updateRestore, "Reconnected to the gun, but couldn't read its settings off the new firmware.");
+                }
+                return;
+            }
+        }
+        if(update.stage != updateIdle) {
+            UpdateFinish(false, "The gun came back, but its port couldn't be picked; connect to it by hand.");
+        }
+        return;
+    }
+    if(++flashReconnectTicks * FLASH_RECONNECT_POLL_MS >= FLASH_RECONNECT_MS) {
+        flashReconnect->stop();
+        if(update.stage != updateIdle) {
+            UpdateFinish(false, QString("The gun was flashed, but didn't come back as Player %1 within %2 seconds.").arg(flashPlayer + 1).arg(FLASH_RECONNECT_MS / 1000));
+            return;
+        }
+        ui->statusBar->showMessage(QString("Flashed, but the gun hasn't come back as Player %1 yet; replug it and pick it from the list.").arg(flashPlayer + 1), 10000);
+    }
+}
+
+
+// One-click update: queue the gun's saved config, reset it, flash it, wait for it to come back,
+// reconnect, and let StagedApply put back whatever the new firmware has differently.
+// Each stage is driven by the same slots as the manual steps, which hand over here while update.stage is set.
+void guiWindow::UpdateBegin()
+{
+    if(update.stage != updateIdle || flasher->IsBusy() || bootloaderWatcher->IsWaiting()) {
+        return;
+    }
+    QVariant port = ui->comPortSelector->itemData(ui->comPortSelector->currentIndex());
+    if(!serialPort.isOpen() || !port.isValid()) {
+        PopupWindow("No gun connected!", "Connect to the gun first: its settings are read before the update and put back after.", "Oops!", 3);
+        return;
+    }
+    if(cacheKey.isEmpty()) {
+        PopupWindow("Can't update this gun in one go!", "It has no USB serial number or TinyUSB id to recognise it by after flashing.\nFlash it by hand instead.", "Oops!", 3);
+        return;
+    }
+    if(dirtyFields.any()) {
+        PopupWindow("Unsaved changes!", "Save or undo your changes first; the update puts back what the gun has saved.", "Oops!", 3);
+        return;
+    }
+    const QSerialPortInfo gun = serialFoundList[port.toInt()];
+    uint8_t player = 0;
+    while(player < 3 && QPair<int, int>(gun.vendorIdentifier(), gun.productIdentifier()) != playerUsbIds[player]) {
+        player++;
+    }
+
+    update = updateRun_s();
+    update.key = cacheKey;
+    update.player = player;
+    update.version = fwVersionBox->currentData().toString();
+    update.total.start();
+    update.stage = updateSnapshot;
+    update.stageTimer.start();
+    QString error;
+    if(!PlayerImage(update.version, player, update.image, error)) {
+        UpdateFinish(false, error);
+        return;
+    }
+    // Read off the gun now rather than trusting gunConfig_orig, which may have come from the cache.
+    update.snapshot.Clear();
+    TinyUSBRead(update.snapshot);
+    const bool snapped = SerialLoad(update.snapshot);
+    serialActive = false;
+    if(!snapped) {
+        UpdateFinish(false, "Couldn't read the gun's settings to keep them; nothing was flashed.");
+        return;
+    }
+    // Queued like an offline config, so it also survives a failed update (or the app closing) and gets applied on the next connect.
+    stagedConfig_s staged;
+    staged.boardId = board.def ? board.def->id : "";
+    staged.config = update.snapshot;
+    staged.fields.set();
+    staged.fields.reset(fieldSelectedProfile);
+    stagedConfigs.Stage(update.key, staged);
+    // Whatever was cached is for the old firmware; the reconnect has to read the new one for real.
+    configCache.Forget(update.key);
+
+    UpdateStage(updateReset);
+    flashPlayer = player;
+    ui->comPortSelector->setCurrentIndex(0);
+    ui->statusBar->showMessage(QString("Updating Player %1: resetting to the bootloader...").arg(player + 1));
+    if(!bootloaderWatcher->Reset(gun)) {
+        UpdateFinish(false, "The gun's serial port couldn't be opened to reset it.");
+    }
+}
+
+
+void guiWindow::UpdateStage(uint8_t next)
+{
+    update.stageMs[update.stage] = update.stageTimer.elapsed();
+    qDebug() << "Update stage" << update.stage << "took" << update.stageMs[update.stage] << "ms";
+    update.stage = next;
+    update.stageTimer.start();
+}
+
+
+void guiWindow::UpdateFinish(bool ok, const QString &why)
+{
+    static const char *stageNames[updateStagesCount] = { "", "snapshot", "reset", "drive", "flash", "reconnect", "restore" };
+    const uint8_t failedAt = update.stage;
+    UpdateStage(updateIdle);
+    QStringList timings;
+    for(uint8_t stage = updateSnapshot; stage < updateStagesCount; stage++) {
+        if(update.stageMs[stage] || stage == failedAt) {
+            timings.append(QString("%1 %2 ms").arg(stageNames[stage]).arg(update.stageMs[stage]));
+        }
+    }
+    const QString summary = QString("Took %1 s: %2.").arg(update.total.elapsed() / 1000.0, 0, 'f', 1).arg(timings.join(", "));
+    qDebug() << "Update" << (ok ? "finished." : "failed:") << why << summary;
+    ui->statusBar->clearMessage();
+    update.image = Uf2Image();
+
+    // Whatever's still queued goes back on by itself the next time the gun connects.
+    const bool queued = stagedConfigs.Find(update.key) != nullptr;
+    if(queued) {
+        stagedTried.remove(update.key);
+        StagedWatchUpdate();
+    }
+    if(ok && !queued) {
+        PopupWindow("Update finished!", QString("Player %1 is on %2, with %3 setting(s) put back.\n\n%4")
+                    .arg(update.player + 1).arg(update.version.isEmpty() ? "the local firmware" : "v" + update.version).arg(update.restored).arg(summary),
+                    "Update", 2);
+    } else if(ok) {
+        PopupWindow("Update flashed, settings not restored!", QString("The firmware went on, but putting back the gun's settings failed. They're still queued and will be retried the next time it connects.\n\n%1").arg(summary), "Update", 3);
+    } else {
+        PopupWindow("Update failed!", QString("%1\n\n%2%3").arg(why, queued ? "The gun's settings are queued and will be put back the next time it connects.\n" : "", summary), "Update", 4);
+    }
+}
 
-    QString fileName = "Player" + QString::number(ui->cbPlayer->currentIndex() + 1) + ".uf2";
-    QString sourcePath = "./uf2/" + fileName;
-    QFile sourceFile(sourcePath);
-    if (!sourceFile.open(QIODevice::ReadOnly)) {
-        QMessageBox::critical(this, tr("Error"), tr("Failed to open source file"));
+
+void guiWindow::FlashAll()
+{
+    if(flasher->IsBusy() || bootloaderWatcher->IsWaiting()) {
+        return;
+    }
+    QList<BatchFlashDialog::batchGun_s> guns;
+    const QList<QSerialPortInfo> ports = QSerialPortInfo::availablePorts();
+    for(const QSerialPortInfo &port : ports) {
+        for(uint8_t i = 0; i < 4; i++) {
+            if(QPair<int, int>(port.vendorIdentifier(), port.productIdentifier()) == playerUsbIds[i]) {
+                guns.append({port, i, playerUsbIds[i]});
+                break;
+            }
+        }
+    }
+    if(guns.isEmpty()) {
+        PopupWindow("No guns connected!", "Plug in the guns to flash; each one keeps the player slot it's set to now.", "Oops!", 3);
         return;
     }
 
-    QString destinationPath = selectedDrive + "/" + fileName;
-    if (!QFile::copy(sourcePath, destinationPath)) {
-        qDebug()<<"copy error";
+    // Every image is checked before any gun gets reset.
+    Uf2Image images[4];
+    for(const BatchFlashDialog::batchGun_s &gun : guns) {
+        QString error;
+        if(images[gun.player].Data().isEmpty() && !PlayerImage(fwVersionBox->currentData().toString(), gun.player, images[gun.player], error)) {
+            QMessageBox::critical(this, tr("Error"), error);
+            return;
+        }
     }
 
-    sourceFile.close();
+    // Let go of the current gun first, it's getting reset with the rest.
+    ui->comPortSelector->setCurrentIndex(0);
+    BatchFlashDialog *dialog = new BatchFlashDialog(guns, images, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    connect(dialog, &QDialog::finished, this, [this]() {
+        PortsSearch();
+    });
+    dialog->open();
+    dialog->Start();
+}
 
-    exit(1);
+// Lists the firmware versions the catalog has for FlashBoard(), keeping the current pick if it's still there.
+void guiWindow::FirmwareVersionsRefresh()
+{
+    const QString current = fwVersionBox->currentData().toString();
+    fwVersionBox->clear();
+    const QStringList versions = firmwareCatalog.Versions(FlashBoard());
+    for(const QString &version : versions) {
+        fwVersionBox->addItem(version.isEmpty() ? "Local files" : QString("v%1 (%2)").arg(version, FlashBoard()), version);
+    }
+    if(versions.isEmpty()) {
+        fwVersionBox->addItem(QString("No firmware for %1").arg(FlashBoard()), QString());
+    }
+    const int index = fwVersionBox->findData(current);
+    fwVersionBox->setCurrentIndex(index < 0 ? 0 : index);
 }
 
 void guiWindow::on_pbRefreshDev_clicked()
 {
+    FirmwareVersionsRefresh();
     ui->cbUsbDev->clear();
+    if(!BootloaderWatcher::StandIn().isEmpty()) {
+        ui->cbUsbDev->addItem(QString(BOOTLOADER_LABEL " stand-in (%1)").arg(BootloaderWatcher::StandIn()), BootloaderWatcher::StandIn());
+    }
     for (const QStorageInfo &storage : QStorageInfo::mountedVolumes()) {
         if (storage.isValid() && storage.isReady() && !storage.isReadOnly()) {
 #ifdef Q_OS_UNIX
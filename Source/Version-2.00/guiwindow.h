@@ -20,8 +20,16 @@
 
 #include <QMainWindow>
 #include <QSerialPort>
+#include <QSet>
+#include <QVector>
 #include <QGraphicsItem>
 #include <QPen>
+#include "configcache.h"
+#include "configfields.h"
+#include "confighistory.h"
+#include "pinmap.h"
+#include "uf2image.h"
+#include <QElapsedTimer>
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -29,6 +37,70 @@ class guiWindow;
 }
 QT_END_NAMESPACE
 
+class BoardView;
+class BootloaderWatcher;
+class ImageOverlay;
+class Uf2Flasher;
+class QCheckBox;
+class QComboBox;
+class QLineEdit;
+class QListWidget;
+class QProgressBar;
+class QPushButton;
+class QSpinBox;
+class QTimer;
+
+// Tunables that get streamed to the gun while live preview is on (bit = settingsTypes_e)
+#define PREVIEW_SETTINGS ((1 << rumbleStrength) | (1 << rumbleInterval) | (1 << solenoidNormalInterval) | (1 << solenoidFastInterval) | (1 << solenoidHoldLength))
+// Minimum time between preview sends
+#define PREVIEW_INTERVAL_MS 50
+// How often to look for guns with a queued offline config while any are queued
+#define STAGED_WATCH_MS 1000
+// How often, and for how long, to look for a gun coming back after being flashed
+#define FLASH_RECONNECT_POLL_MS 250
+#define FLASH_RECONNECT_MS 15000
+
+// Stages of a one-click firmware update, in order
+enum updateStages_e {
+    updateIdle = 0,
+    // Queue the gun's current config to be put back
+    updateSnapshot,
+    // 1200 baud touch until the gun's serial port goes away
+    updateReset,
+    // Until its bootloader drive is mounted
+    updateDrive,
+    // Write and read back
+    updateFlash,
+    // Until the new firmware enumerates and we've connected and read its config
+    updateReconnect,
+    // Writing back whatever the new firmware doesn't have
+    updateRestore,
+    updateStagesCount
+};
+
+// A one-click update in progress.
+typedef struct updateRun_t {
+    uint8_t stage = updateIdle;
+    // Config cache key of the gun being updated
+    QString key;
+    uint8_t player = 0;
+    QString version;
+    Uf2Image image;
+    // The gun's saved config before the update
+    gunConfig_s snapshot;
+    // Fields the restore's commit actually wrote back
+    int restored = 0;
+    QElapsedTimer total;
+    QElapsedTimer stageTimer;
+    qint64 stageMs[updateStagesCount] = {};
+} updateRun_s;
+
+// One write of a commit, and the configFields_e it carries.
+typedef struct commitWrite_t {
+    uint8_t field;
+    QString command;
+} commitWrite_s;
+
 class guiWindow : public QMainWindow
 {
     Q_OBJECT
@@ -67,41 +139,37 @@ private slots:
 
     void serialPort_readyRead();
 
-    void pinBoxes_activated(int index);
+    void pinBoxes_activated(uint8_t pin, int index);
 
     void irBoxes_activated(int index);
 
     void runModeBoxes_activated(int index);
 
-    // void on_customPinsEnabled_stateChanged(int arg1);
+    void customPinsToggle_stateChanged(int arg1);
 
-    void on_rumbleTestBtn_clicked();
+    void autoPinsBtn_toggled(bool checked);
 
-    void on_solenoidTestBtn_clicked();
+    void livePreviewToggle_toggled(bool checked);
 
-    void on_baudResetBtn_clicked();
-
-    void on_rumbleToggle_stateChanged(int arg1);
+    void PreviewFlush();
 
-    void on_solenoidToggle_stateChanged(int arg1);
+    void LibraryRefresh();
 
-    void on_autofireToggle_stateChanged(int arg1);
+    void LibrarySave();
 
-    void on_holdToPauseToggle_stateChanged(int arg1);
+    void LibraryLoad();
 
-    void on_rumbleIntensityBox_valueChanged(int arg1);
+    void LibraryDelete();
 
-    void on_rumbleLengthBox_valueChanged(int arg1);
+    void OfflineBegin();
 
-    void on_holdToPauseLengthBox_valueChanged(int arg1);
+    void StagedWatch();
 
-    void on_solenoidNormalIntervalBox_valueChanged(int arg1);
-
-    void on_solenoidFastIntervalBox_valueChanged(int arg1);
+    void on_rumbleTestBtn_clicked();
 
-    void on_solenoidHoldLengthBox_valueChanged(int arg1);
+    void on_solenoidTestBtn_clicked();
 
-    void on_autofireWaitFactorBox_valueChanged(int arg1);
+    void on_baudResetBtn_clicked();
 
     void on_clearEepromBtn_new_clicked();
 
@@ -119,8 +187,30 @@ private slots:
 
     void on_actionAbout_IR_PIGS_triggered();
 
+    void BootloaderPortGone(qint64 elapsedMs);
+
+    void BootloaderResetFailed();
+
+    void BootloaderFound(const QString &mountPath, qint64 elapsedMs);
+
+    void BootloaderTimedOut(qint64 elapsedMs);
+
     void on_pbTransfer_clicked();
 
+    void FlashProgress(qint64 written, qint64 total);
+
+    void FlashFinished(bool ok, qint64 elapsedMs);
+
+    void FlashReconnect();
+
+    // Reflashes every connected gun at once, each with its own player's image.
+    void FlashAll();
+
+    void FirmwareVersionsRefresh();
+
+    // Updates the connected gun's firmware and puts its config back afterwards.
+    void UpdateBegin();
+
     void on_pbRefreshDev_clicked();
 
     void on_pbReboot_clicked();
@@ -128,6 +218,9 @@ private slots:
 private:
     Ui::guiWindow *ui;
 
+    // Shared overlay for the setup/tips/calibration pictures, hidden instead of deleted on close.
+    ImageOverlay *imageOverlay;
+
     // Used by pinBoxes, matching boardInputs_e
     QStringList valuesNameList = {
         "Unmapped",
@@ -163,32 +256,85 @@ private:
     // Extracted COM paths, as provided from serialFoundList
     QStringList usbName;
 
-    // Tracks the amount of differences between current config and loaded config.
-    // Resets after every call to DiffUpdate()
-    uint8_t settingsDiff;
-
-    // Current array of booleans, meant to be used as a bitmask
-    bool boolSettings[8];
-    // Array of booleans, as loaded from the gun firmware
-    bool boolSettings_orig[8];
-
-    // Current table of tunable settings
-    uint16_t settingsTable[8];
-    // Table of tunables, as loaded from gun firmware
-    uint16_t settingsTable_orig[8];
-
-    // because pinBoxes' "->currentIndex" gets updated AFTER calling its activation signal,
-    // we need to save its last index to properly compare and prevent duplicate changes,
+    // Which configFields_e currently differ from the config loaded from the gun.
+    // Kept up to date by the Set* functions below, rebuilt in full by DiffUpdate().
+    configFieldSet_t dirtyFields;
+    // Writes the last successful commit sent, i.e. how many fields it changed on the gun
+    int commitWrites = 0;
+
+    QCheckBox *livePreviewToggle;
+    QTimer *previewTimer;
+    // Tunables (bit = settingsTypes_e) waiting for the next preview send
+    uint8_t previewPending = 0;
+    // Tunables sent as a preview that the gun's flash doesn't have yet
+    uint8_t previewApplied = 0;
+
+    // Config cache key of the connected gun ("usb:<serial>" or "tinyusb:<id>"), empty if it has neither
+    QString cacheKey;
+    // Whether this connect read the whole config off the gun, rather than taking it from the cache
+    bool configFresh = false;
+
+    // Profile library widgets, on the calibration tab
+    QLineEdit *librarySearch;
+    QCheckBox *libraryGunOnly;
+    QListWidget *libraryList;
+
+    // Gun (config cache key) the config is being prepared for offline; empty when editing a connected gun
+    QString offlineKey;
+    // Fields the offline config started out applying, when it's a queued one being re-edited
+    configFieldSet_t offlineFields;
+    QPushButton *offlineBtn;
+    QTimer *stagedWatch;
+    // Guns whose queued config was already tried this session
+    QSet<QString> stagedTried;
+
+    BootloaderWatcher *bootloaderWatcher;
+    Uf2Flasher *flasher;
+    QProgressBar *flashProgress = nullptr;
+    // Player index last flashed, to know which gun to wait for
+    int flashPlayer = 0;
+    QTimer *flashReconnect;
+    int flashReconnectTicks = 0;
+    QPushButton *flashAllBtn;
+    QPushButton *updateBtn;
+    updateRun_s update;
+    QComboBox *fwVersionBox;
+
+    // Undo/redo log of edits made since the gun was loaded
+    ConfigHistory history;
+    // Set while the history is being played back, so that doesn't get recorded again
+    bool historyReplaying = false;
+
+    // Widget editing each bool/tunable (by boolTypes_e / settingsTypes_e), null where there's none
+    QCheckBox *boolWidgets[8] = {};
+    QSpinBox *settingWidgets[8] = {};
+
+    // because the comboboxes' "->currentIndex" gets updated AFTER calling their activation signal,
+    // we need to save the last index to properly compare and prevent duplicate changes,
     // and then update it at the end of the activate signal.
-    int pinBoxesOldIndex[30];
-
-    // Uses the same logic as pinBoxesOldIndex, since the irSensor and runMode comboboxes
-    // are hooked to a single signal.
+    // (pinBoxes don't need this, gunConfig.pins already knows what each pin held.)
     uint8_t irSensOldIndex[4];
     uint8_t runModeOldIndex[4];
 
     bool testMode = false;
 
+    // Pin Mapping tab, holding the pooled pinBoxes/pinLabel widgets.
+    QWidget *pinsTab;
+
+    // pinTypes_e each pinBoxes entry is currently populated for (0xFF = not yet),
+    // so a board switch only rebuilds the combos whose pin type differs.
+    uint8_t pinBoxesType[30];
+
+    // Board picture between the two pin columns, marking where things are mapped.
+    BoardView *boardView;
+
+    QCheckBox *customPinsToggle;
+    QPushButton *autoPinsBtn;
+
+    // Pins the user has set by hand since the mapping was last loaded;
+    // the auto-assigner works around these instead of moving them.
+    uint32_t pinsLocked = 0;
+
     // Test Mode screen points & colors
     QGraphicsEllipseItem testPointTL;
     QGraphicsEllipseItem testPointTR;
@@ -211,8 +357,72 @@ private:
 
     void BoxesUpdate();
 
+    void BoxesSync();
+
+    uint32_t PinsSolve(uint32_t wanted, const pinMap_s &hint);
+
+    void PinBoxesRefresh();
+
     void DiffUpdate();
 
+    void ConfirmButtonUpdate();
+
+    int32_t FieldValue(uint8_t field, bool orig = false) const;
+
+    bool FieldDiffers(uint8_t field) const;
+
+    void FieldDirty(uint8_t field, bool dirty);
+
+    void SetBool(uint8_t index, bool value);
+
+    void SetSetting(uint8_t index, uint16_t value);
+
+    void SetProfileField(uint8_t slot, uint8_t field, int32_t value);
+
+    void SetSelectedProfile(uint8_t slot);
+
+    void PinsChanged(const pinMap_s &before);
+
+    void PinsDirtyRecheck();
+
+    void FieldEdited(uint8_t field, int32_t from, int32_t to);
+
+    void ApplyField(uint8_t field, int32_t value);
+
+    void HistoryStep(bool redo);
+
+    void PreviewQueue(uint8_t settings);
+
+    void PreviewRevert();
+    bool PreviewSend(uint8_t settings, const gunConfig_s &config);
+
+    QString FieldName(uint8_t field) const;
+
+    QString FieldCommand(uint8_t field, bool orig = false) const;
+
+    bool CommitSend(const QString &command);
+
+    bool CommitReadBack(gunConfig_s &device);
+
+    bool CommitSettings();
+
+    void ConfigWidgetsRefresh();
+
+    void OfflineStage();
+
+    void StagedApply();
+
+    void StagedWatchUpdate();
+
+    // Ends the update's current stage (timing it) and starts next.
+    void UpdateStage(uint8_t next);
+
+    void UpdateFinish(bool ok, const QString &why = QString());
+
+    void CommitRollback(const QVector<commitWrite_s> &writes, int touched, const QString &failure);
+
+    QStringList ChangedFields() const;
+
     void PopupWindow(QString errorTitle, QString errorMessage, QString windowTitle, int errorType);
 
     void PortsSearch();
@@ -221,7 +431,17 @@ private:
 
     bool SerialInit(int portNum);
 
-    void SerialLoad();
+    bool SerialLoad(gunConfig_s &config);
+
+    bool ProfileRead(uint8_t slot, gunConfig_s &config);
+
+    void TinyUSBRead(gunConfig_s &config);
+
+    bool BlocksRead(gunConfig_s &config);
+
+    void ConfigApply(const gunConfig_s &config);
+
+    void CacheStore();
 
     void SyncSettings();
 
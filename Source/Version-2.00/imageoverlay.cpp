@@ -0,0 +1,81 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "imageoverlay.h"
+#include <QEvent>
+#include <QLabel>
+#include <QPushButton>
+#include <QtDebug>
+
+ImageOverlay::ImageOverlay(QWidget *parent)
+    : QWidget(parent)
+{
+    imageLabel = new QLabel(this);
+    imageLabel->setAlignment(Qt::AlignCenter);
+
+    closeButton = new QPushButton("Close", this);
+    closeButton->setStyleSheet("font-size: 16px; background-color: red; color: white;");
+    connect(closeButton, &QPushButton::clicked, this, &QWidget::hide);
+
+    // Follow the window around, so we rescale on resize instead of on every click.
+    parent->installEventFilter(this);
+    hide();
+}
+
+void ImageOverlay::ShowImage(const QString &path)
+{
+    if(!images.contains(path)) {
+        overlayImage_s entry;
+        if(!entry.source.load(path)) {
+            qDebug() << "Couldn't load overlay image" << path;
+        }
+        images.insert(path, entry);
+    }
+    currentPath = path;
+    Relayout();
+    raise();
+    show();
+}
+
+bool ImageOverlay::eventFilter(QObject *obj, QEvent *event)
+{
+    if(obj == parent() && event->type() == QEvent::Resize && isVisible()) {
+        Relayout();
+    }
+    return QWidget::eventFilter(obj, event);
+}
+
+void ImageOverlay::Relayout()
+{
+    const QWidget *window = parentWidget();
+    setGeometry(0, 0, window->width(), window->height());
+    imageLabel->setGeometry(0, 0, width(), height());
+    // Position the button in the bottom right corner
+    closeButton->setGeometry(width() - 100, height() - 50, 80, 40);
+    UpdatePixmap();
+}
+
+void ImageOverlay::UpdatePixmap()
+{
+    overlayImage_s &entry = images[currentPath];
+    if(entry.scaledFor != size()) {
+        // Only hit when the window changed size since this image was last shown.
+        entry.scaled = QPixmap::fromImage(entry.source.scaled(size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
+        entry.scaledFor = size();
+    }
+    imageLabel->setPixmap(entry.scaled);
+}
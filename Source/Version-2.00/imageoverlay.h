@@ -0,0 +1,66 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMAGEOVERLAY_H
+#define IMAGEOVERLAY_H
+
+#include <QWidget>
+#include <QHash>
+#include <QImage>
+#include <QPixmap>
+
+class QLabel;
+class QPushButton;
+
+// Full-window picture overlay used by the setup, tips and calibration screens.
+// One instance lives for the whole session: images are decoded once on first use,
+// the scaled copy is kept per image and only rebuilt when the window size changes,
+// and closing just hides the overlay.
+class ImageOverlay : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ImageOverlay(QWidget *parent);
+
+    // Covers the parent window with the image at resource/file path.
+    void ShowImage(const QString &path);
+
+protected:
+    bool eventFilter(QObject *obj, QEvent *event) override;
+
+private:
+    typedef struct overlayImage_t {
+        QImage source;
+        QPixmap scaled;
+        QSize scaledFor;
+    } overlayImage_s;
+
+    // Decoded images, keyed by path. Entries are never dropped, there's only a handful.
+    QHash<QString, overlayImage_s> images;
+
+    QString currentPath;
+
+    QLabel *imageLabel;
+    QPushButton *closeButton;
+
+    void Relayout();
+
+    void UpdatePixmap();
+};
+
+#endif // IMAGEOVERLAY_H
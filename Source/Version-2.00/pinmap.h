@@ -0,0 +1,145 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PINMAP_H
+#define PINMAP_H
+
+#include "constants.h"
+#include <cstring>
+#include <type_traits>
+
+// Inputs that need an ADC pin; bit = boardInputs_e - 1, same as pinMap_t::inputPin.
+constexpr uint32_t analogOnlyInputs = (1u << (tempPin - 1)) | (1u << (analogX - 1)) | (1u << (analogY - 1));
+
+// What each pin of a board can host, as bitmasks (bit = GPIO number).
+// Built once per board from its boardLayout_t so placement checks are a single AND.
+typedef struct pinCaps_t {
+    // Pins that can take any digital function (ADC pins included)
+    uint32_t digital = 0;
+    // Pins that can also take analog-only functions
+    uint32_t analog = 0;
+
+    void Load(const boardLayout_t *layout)
+    {
+        digital = 0;
+        analog = 0;
+        for(uint8_t i = 0; i < 30; i++) {
+            if(layout[i].pinType == pinAnalog) {
+                analog |= 1u << i;
+                digital |= 1u << i;
+            } else if(layout[i].pinType == pinDigital) {
+                digital |= 1u << i;
+            }
+        }
+    }
+
+    // Can input (a boardInputs_e above btnUnmapped) live on this pin?
+    bool Fits(uint8_t pin, uint8_t input) const
+    {
+        uint32_t allowed = (analogOnlyInputs & (1u << (input - 1))) ? analog : digital;
+        return allowed & (1u << pin);
+    }
+} pinCaps_s;
+
+// Two-way index of which input sits on which pin.
+// Plain fixed-size data, so snapshots are a copy and comparisons a memcmp.
+typedef struct pinMap_t {
+    // Bit per pin that has an input on it
+    uint32_t occupiedPins;
+    // Bit per input (boardInputs_e - 1) that has a pin
+    uint32_t mappedInputs;
+    // Function on each pin, as boardInputs_e; btnUnmapped when free,
+    // btnReserved (or -2 for padding) when the layout says the pin can't be used.
+    int8_t pinInput[30];
+    // Pin each input (boardInputs_e - 1) sits on, -1 if unmapped
+    int8_t inputPin[INPUTS_COUNT];
+
+    void Clear()
+    {
+        occupiedPins = 0;
+        mappedInputs = 0;
+        memset(pinInput, btnUnmapped, sizeof(pinInput));
+        memset(inputPin, -1, sizeof(inputPin));
+    }
+
+    // Default mapping of a board's layout.
+    void LoadLayout(const boardLayout_t *layout)
+    {
+        Clear();
+        for(uint8_t i = 0; i < 30; i++) {
+            pinInput[i] = layout[i].pinAssignment;
+            if(layout[i].pinAssignment > btnUnmapped) {
+                inputPin[layout[i].pinAssignment - 1] = i;
+                occupiedPins |= 1u << i;
+                mappedInputs |= 1u << (layout[i].pinAssignment - 1);
+            }
+        }
+    }
+
+    void UnassignPin(uint8_t pin)
+    {
+        if(occupiedPins & (1u << pin)) {
+            uint8_t input = pinInput[pin];
+            inputPin[input - 1] = -1;
+            mappedInputs &= ~(1u << (input - 1));
+            pinInput[pin] = btnUnmapped;
+            occupiedPins &= ~(1u << pin);
+        }
+    }
+
+    // Puts input (a boardInputs_e above btnUnmapped) on pin, replacing whatever was there.
+    // Returns the pin the input was moved off of, or -1 if it wasn't mapped elsewhere.
+    int8_t Assign(uint8_t pin, uint8_t input)
+    {
+        int8_t displaced = inputPin[input - 1];
+        if(displaced == pin) {
+            return -1;
+        }
+        if(displaced >= 0) {
+            UnassignPin(displaced);
+        }
+        UnassignPin(pin);
+        pinInput[pin] = input;
+        inputPin[input - 1] = pin;
+        occupiedPins |= 1u << pin;
+        mappedInputs |= 1u << (input - 1);
+        return displaced;
+    }
+
+    // Bit per input (boardInputs_e - 1) whose pin differs from other's.
+    uint32_t InputsDiff(const pinMap_t &other) const
+    {
+        uint32_t diff = mappedInputs ^ other.mappedInputs;
+        uint32_t both = mappedInputs & other.mappedInputs;
+        for(uint8_t i = 0; i < INPUTS_COUNT; i++) {
+            if((both & (1u << i)) && inputPin[i] != other.inputPin[i]) {
+                diff |= 1u << i;
+            }
+        }
+        return diff;
+    }
+
+    bool SameInputs(const pinMap_t &other) const
+    {
+        return memcmp(inputPin, other.inputPin, sizeof(inputPin)) == 0;
+    }
+} pinMap_s;
+
+static_assert(std::is_trivially_copyable<pinMap_s>::value, "pinMap_s must stay a plain copyable struct");
+static_assert(INPUTS_COUNT <= 32 && sizeof(pinMap_s::pinInput) <= 32, "pinMap_s bitsets are 32 bits wide");
+
+#endif // PINMAP_H
@@ -0,0 +1,128 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pinsolver.h"
+
+typedef struct solverState_t {
+    // Pins each input (bit = boardInputs_e - 1) may go on
+    uint32_t candidates[INPUTS_COUNT];
+    // Preferred pin per input, -1 if none
+    int8_t preferred[INPUTS_COUNT];
+    // Input currently holding each pin (as boardInputs_e - 1), -1 if free
+    int8_t pinOwner[30];
+    // Pins already visited in the current augmenting search
+    uint32_t visited;
+} solverState_s;
+
+// Lowest set bit, as a pin number
+static inline uint8_t LowestPin(uint32_t mask)
+{
+    uint8_t pin = 0;
+    while(!(mask & 1u)) {
+        mask >>= 1;
+        pin++;
+    }
+    return pin;
+}
+
+// Tries to find input a pin, bumping earlier inputs to other pins if that frees one up.
+static bool Augment(solverState_s &state, uint8_t input)
+{
+    uint32_t options = state.candidates[input] & ~state.visited;
+    // Preferred pin first, so a solvable board keeps its familiar layout.
+    if(state.preferred[input] >= 0 && (options & (1u << state.preferred[input]))) {
+        uint8_t pin = state.preferred[input];
+        state.visited |= 1u << pin;
+        if(state.pinOwner[pin] < 0 || Augment(state, state.pinOwner[pin])) {
+            state.pinOwner[pin] = input;
+            return true;
+        }
+        options &= ~(1u << pin);
+    }
+    // Free pins next, which never disturb anything...
+    uint32_t free = 0;
+    for(uint32_t scan = options; scan; scan &= scan - 1) {
+        uint8_t pin = LowestPin(scan);
+        if(state.pinOwner[pin] < 0) {
+            free |= 1u << pin;
+        }
+    }
+    if(free) {
+        uint8_t pin = LowestPin(free);
+        state.visited |= 1u << pin;
+        state.pinOwner[pin] = input;
+        return true;
+    }
+    // ...and only then try displacing someone.
+    for(; options; options &= options - 1) {
+        uint8_t pin = LowestPin(options);
+        if(state.visited & (1u << pin)) {
+            continue;
+        }
+        state.visited |= 1u << pin;
+        if(Augment(state, state.pinOwner[pin])) {
+            state.pinOwner[pin] = input;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t SolvePins(const pinCaps_s &caps, const pinConstraints_s &constraints, pinMap_s &out)
+{
+    solverState_s state;
+    uint32_t freePins = caps.digital & ~constraints.lockedPins;
+    uint32_t analogPins = caps.analog & ~constraints.lockedPins;
+
+    out.Clear();
+    // Locked pins go in as-is; the inputs on them are done.
+    uint32_t todo = constraints.wanted;
+    for(uint32_t scan = constraints.lockedPins & constraints.pinned.occupiedPins; scan; scan &= scan - 1) {
+        uint8_t pin = LowestPin(scan);
+        uint8_t input = constraints.pinned.pinInput[pin];
+        out.Assign(pin, input);
+        todo &= ~(1u << (input - 1));
+    }
+
+    for(uint8_t i = 0; i < 30; i++) {
+        state.pinOwner[i] = -1;
+    }
+    for(uint8_t i = 0; i < INPUTS_COUNT; i++) {
+        state.candidates[i] = (analogOnlyInputs & (1u << i)) ? analogPins : freePins;
+        state.preferred[i] = constraints.hint.inputPin[i];
+    }
+
+    // Most constrained first: analog-only inputs have the fewest pins to pick from.
+    uint32_t unplaced = 0;
+    uint32_t order[2] = { todo & analogOnlyInputs, todo & ~analogOnlyInputs };
+    for(uint32_t group : order) {
+        for(; group; group &= group - 1) {
+            uint8_t input = LowestPin(group);
+            state.visited = 0;
+            if(!Augment(state, input)) {
+                unplaced |= 1u << input;
+            }
+        }
+    }
+
+    for(uint8_t pin = 0; pin < 30; pin++) {
+        if(state.pinOwner[pin] >= 0) {
+            out.Assign(pin, state.pinOwner[pin] + 1);
+        }
+    }
+    return unplaced;
+}
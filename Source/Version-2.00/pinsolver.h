@@ -0,0 +1,43 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PINSOLVER_H
+#define PINSOLVER_H
+
+#include "pinmap.h"
+
+// What the auto-assigner has to work with.
+typedef struct pinConstraints_t {
+    // Inputs that need a pin (bit = boardInputs_e - 1)
+    uint32_t wanted = 0;
+    // Pins the user has fixed; their current assignment in "pinned" is kept as-is,
+    // and if they're empty there, they stay empty.
+    uint32_t lockedPins = 0;
+    pinMap_s pinned;
+    // Where each input would preferably go (e.g. the board's default layout).
+    // Only a tiebreaker, never a requirement.
+    pinMap_s hint;
+} pinConstraints_s;
+
+// Places every wanted input on a pin the board allows for it, honouring locked pins.
+// This is a bipartite matching (inputs <-> free pins) solved with augmenting paths over
+// pin bitmasks; with 25 inputs and 30 pins it runs in a few microseconds, cheap enough
+// to re-run on every edit.
+// Writes the result to out and returns the wanted inputs that couldn't be placed (0 on success).
+uint32_t SolvePins(const pinCaps_s &caps, const pinConstraints_s &constraints, pinMap_s &out);
+
+#endif // PINSOLVER_H
@@ -0,0 +1,201 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "profilelibrary.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtDebug>
+#include <algorithm>
+
+static QJsonObject EntryToJson(const libraryProfile_s &entry)
+{
+    QJsonObject obj;
+    obj["name"] = entry.name;
+    obj["gun"] = entry.gunKey;
+    obj["display"] = entry.display;
+    obj["xScale"] = entry.profile.xScale;
+    obj["yScale"] = entry.profile.yScale;
+    obj["xCenter"] = entry.profile.xCenter;
+    obj["yCenter"] = entry.profile.yCenter;
+    obj["irSensitivity"] = entry.profile.irSensitivity;
+    obj["runMode"] = entry.profile.runMode;
+    return obj;
+}
+
+static libraryProfile_s EntryFromJson(const QJsonObject &obj)
+{
+    libraryProfile_s entry;
+    entry.name = obj["name"].toString();
+    entry.gunKey = obj["gun"].toString();
+    entry.display = obj["display"].toString();
+    entry.profile.xScale = obj["xScale"].toInt();
+    entry.profile.yScale = obj["yScale"].toInt();
+    entry.profile.xCenter = obj["xCenter"].toInt();
+    entry.profile.yCenter = obj["yCenter"].toInt();
+    entry.profile.irSensitivity = obj["irSensitivity"].toInt();
+    entry.profile.runMode = obj["runMode"].toInt();
+    return entry;
+}
+
+void ProfileLibrary::Load(const QString &path)
+{
+    this->path = path;
+    entries.clear();
+    searchText.clear();
+    byGun.clear();
+    byDisplay.clear();
+
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QJsonArray profiles = QJsonDocument::fromJson(file.readAll()).object()["profiles"].toArray();
+    for(const QJsonValue &value : profiles) {
+        libraryProfile_s entry = EntryFromJson(value.toObject());
+        if(entry.name.isEmpty()) {
+            qDebug() << "Skipping unnamed library profile in" << path;
+            continue;
+        }
+        Insert(entry);
+    }
+}
+
+int ProfileLibrary::Insert(const libraryProfile_s &entry)
+{
+    int id = nextId++;
+    entries.insert(id, entry);
+    searchText.insert(id, (entry.name + " " + entry.display).toLower());
+    byGun.insert(entry.gunKey, id);
+    byDisplay.insert(entry.display, id);
+    return id;
+}
+
+int ProfileLibrary::Add(const libraryProfile_s &entry)
+{
+    for(int id : byGun.values(entry.gunKey)) {
+        const libraryProfile_s &old = *entries.constFind(id);
+        if(old.display == entry.display && old.name == entry.name) {
+            Erase(id);
+            break;
+        }
+    }
+    int id = Insert(entry);
+    Save();
+    return id;
+}
+
+void ProfileLibrary::Remove(int id)
+{
+    if(Erase(id)) {
+        Save();
+    }
+}
+
+bool ProfileLibrary::Erase(int id)
+{
+    auto it = entries.find(id);
+    if(it == entries.end()) {
+        return false;
+    }
+    byGun.remove(it->gunKey, id);
+    byDisplay.remove(it->display, id);
+    searchText.remove(id);
+    entries.erase(it);
+    return true;
+}
+
+const libraryProfile_s *ProfileLibrary::Get(int id) const
+{
+    auto it = entries.constFind(id);
+    return it == entries.constEnd() ? nullptr : &it.value();
+}
+
+QVector<int> ProfileLibrary::Search(const QString &query, const QString &gunKey, const QString &display) const
+{
+    // Start from the smallest index that applies.
+    QList<int> candidates;
+    if(!gunKey.isEmpty() && !display.isEmpty()) {
+        candidates = byGun.count(gunKey) < byDisplay.count(display) ? byGun.values(gunKey) : byDisplay.values(display);
+    } else if(!gunKey.isEmpty()) {
+        candidates = byGun.values(gunKey);
+    } else if(!display.isEmpty()) {
+        candidates = byDisplay.values(display);
+    } else {
+        candidates = entries.keys();
+    }
+
+    const QStringList words = query.toLower().split(' ', Qt::SkipEmptyParts);
+    QVector<int> found;
+    for(int id : candidates) {
+        const libraryProfile_s &entry = *entries.constFind(id);
+        if((!gunKey.isEmpty() && entry.gunKey != gunKey) || (!display.isEmpty() && entry.display != display)) {
+            continue;
+        }
+        const QString &text = *searchText.constFind(id);
+        bool match = true;
+        for(const QString &word : words) {
+            if(!text.contains(word)) {
+                match = false;
+                break;
+            }
+        }
+        if(match) {
+            found.append(id);
+        }
+    }
+    std::sort(found.begin(), found.end(), [this](int a, int b) {
+        return QString::localeAwareCompare(entries.constFind(a)->name, entries.constFind(b)->name) < 0;
+    });
+    return found;
+}
+
+QStringList ProfileLibrary::Displays() const
+{
+    QStringList displays = byDisplay.uniqueKeys();
+    displays.removeAll(QString());
+    std::sort(displays.begin(), displays.end(), [](const QString &a, const QString &b) {
+        return QString::localeAwareCompare(a, b) < 0;
+    });
+    return displays;
+}
+
+bool ProfileLibrary::Save() const
+{
+    if(path.isEmpty()) {
+        return false;
+    }
+    QJsonArray profiles;
+    for(const libraryProfile_s &entry : entries) {
+        profiles.append(EntryToJson(entry));
+    }
+    QJsonObject root;
+    root["profiles"] = profiles;
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Couldn't write profile library" << path;
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson());
+    return file.commit();
+}
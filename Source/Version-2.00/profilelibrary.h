@@ -0,0 +1,78 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROFILELIBRARY_H
+#define PROFILELIBRARY_H
+
+#include "constants.h"
+#include <QHash>
+#include <QMultiHash>
+#include <QString>
+#include <QVector>
+
+// One saved calibration profile.
+typedef struct libraryProfile_t {
+    QString name;
+    // Gun it was calibrated on (its config cache key), empty if it isn't tied to one
+    QString gunKey;
+    // Screen/cabinet it was calibrated for, as named by the user
+    QString display;
+    profilesTable_s profile;
+} libraryProfile_s;
+
+// Local store of any number of named calibration profiles, beyond the gun's four slots.
+// Indexed by gun and by display, with a lowercased search string kept per entry,
+// so narrowing down hundreds of profiles as you type never has to touch the rest.
+class ProfileLibrary
+{
+public:
+    // Reads the library file at path; a missing or broken file just starts out empty.
+    void Load(const QString &path);
+
+    // Adds entry, replacing one of the same name for the same gun and display.
+    // Returns its id.
+    int Add(const libraryProfile_s &entry);
+
+    void Remove(int id);
+
+    // Entry for id, or nullptr if it's gone.
+    const libraryProfile_s *Get(int id) const;
+
+    // Ids of entries whose name or display contain every word of query, sorted by name.
+    // Empty gunKey/display match any.
+    QVector<int> Search(const QString &query, const QString &gunKey = QString(), const QString &display = QString()) const;
+
+    // Every display name in use, sorted.
+    QStringList Displays() const;
+
+private:
+    int Insert(const libraryProfile_s &entry);
+
+    bool Erase(int id);
+
+    bool Save() const;
+
+    QString path;
+    int nextId = 0;
+    QHash<int, libraryProfile_s> entries;
+    // "name display", lowercased, per id
+    QHash<int, QString> searchText;
+    QMultiHash<QString, int> byGun;
+    QMultiHash<QString, int> byDisplay;
+};
+
+#endif // PROFILELIBRARY_H
@@ -0,0 +1,102 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stagedconfigs.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtDebug>
+
+void StagedConfigs::Load(const QString &path)
+{
+    this->path = path;
+    entries.clear();
+
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QJsonObject guns = QJsonDocument::fromJson(file.readAll()).object();
+    for(auto it = guns.constBegin(); it != guns.constEnd(); ++it) {
+        QJsonObject obj = it.value().toObject();
+        stagedConfig_s staged;
+        if(!ConfigFromJson(obj, staged.config)) {
+            qDebug() << "Dropping bad staged config for" << it.key();
+            continue;
+        }
+        staged.boardId = obj["board"].toString();
+        for(const QJsonValue &field : obj["fields"].toArray()) {
+            int index = field.toInt(-1);
+            if(index >= 0 && index < fieldsCount) {
+                staged.fields.set(index);
+            }
+        }
+        entries.insert(it.key(), staged);
+    }
+}
+
+const stagedConfig_s *StagedConfigs::Find(const QString &key) const
+{
+    auto it = entries.constFind(key);
+    return it == entries.constEnd() ? nullptr : &it.value();
+}
+
+void StagedConfigs::Stage(const QString &key, const stagedConfig_s &staged)
+{
+    entries.insert(key, staged);
+    Save();
+}
+
+void StagedConfigs::Remove(const QString &key)
+{
+    if(entries.remove(key)) {
+        Save();
+    }
+}
+
+bool StagedConfigs::Save() const
+{
+    if(path.isEmpty()) {
+        return false;
+    }
+    QJsonObject guns;
+    for(auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        QJsonObject obj = ConfigToJson(it->config);
+        obj["board"] = it->boardId;
+        QJsonArray fields;
+        for(int i = 0; i < fieldsCount; i++) {
+            if(it->fields[i]) {
+                fields.append(i);
+            }
+        }
+        obj["fields"] = fields;
+        guns[it.key()] = obj;
+    }
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Couldn't write staged configs" << path;
+        return false;
+    }
+    file.write(QJsonDocument(guns).toJson());
+    return file.commit();
+}
@@ -0,0 +1,60 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef STAGEDCONFIGS_H
+#define STAGEDCONFIGS_H
+
+#include "configcache.h"
+#include "configfields.h"
+#include <QHash>
+#include <QString>
+
+// A config prepared offline, waiting for its gun to show up.
+typedef struct stagedConfig_t {
+    // Board the config was prepared on, which the pin mapping is only valid for
+    QString boardId;
+    gunConfig_s config;
+    // Which configFields_e to apply; everything else stays as the gun has it
+    configFieldSet_t fields;
+} stagedConfig_s;
+
+// Queue of offline-prepared configs, keyed by gun (config cache key).
+// Kept in one JSON file so staging survives restarts between prepping and walking the floor.
+class StagedConfigs
+{
+public:
+    void Load(const QString &path);
+
+    const stagedConfig_s *Find(const QString &key) const;
+
+    // Queues staged for key, replacing whatever was queued for it before.
+    void Stage(const QString &key, const stagedConfig_s &staged);
+
+    void Remove(const QString &key);
+
+    QStringList Keys() const { return entries.keys(); }
+
+    bool IsEmpty() const { return entries.isEmpty(); }
+
+private:
+    bool Save() const;
+
+    QString path;
+    QHash<QString, stagedConfig_s> entries;
+};
+
+#endif // STAGEDCONFIGS_H
@@ -0,0 +1,167 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Build-time helper that turns the full-size artwork in images/ into the
+// variants the GUI actually draws, so nothing has to be resampled at runtime.
+//
+// Usage: assetbaker <source dir> <output dir> <output qrc> <spec>...
+// where each spec is "path/in/source.png" (keep size) or "path/in/source.png=WxH"
+// (fit inside WxH, plus a path@2x.png variant if the source has the pixels for it).
+// Every image is written as whichever lossless PNG encoding comes out smallest,
+// and the output qrc registers them under their original resource paths.
+
+#include <QCoreApplication>
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageWriter>
+#include <QSet>
+#include <QTextStream>
+#include <QtDebug>
+
+// Encodes img as PNG at maximum compression.
+static QByteArray EncodePng(const QImage &img)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    QImageWriter writer(&buffer, "png");
+    // For PNG, quality maps inversely to the zlib level: 0 is the smallest output.
+    writer.setQuality(0);
+    writer.write(img);
+    return data;
+}
+
+// Tries every lossless representation we know of and keeps the smallest.
+static QByteArray EncodeSmallest(const QImage &img)
+{
+    QImage argb = img.convertToFormat(QImage::Format_ARGB32);
+    bool opaque = true;
+    QSet<QRgb> colors;
+    for(int y = 0; y < argb.height(); y++) {
+        const QRgb *line = reinterpret_cast<const QRgb*>(argb.constScanLine(y));
+        for(int x = 0; x < argb.width(); x++) {
+            if(qAlpha(line[x]) != 255) {
+                opaque = false;
+            }
+            if(colors.size() <= 256) {
+                colors.insert(line[x]);
+            }
+        }
+    }
+
+    QByteArray best = EncodePng(argb);
+    if(opaque) {
+        QByteArray rgb = EncodePng(argb.convertToFormat(QImage::Format_RGB32));
+        if(rgb.size() < best.size()) {
+            best = rgb;
+        }
+    }
+    if(colors.size() <= 256) {
+        // Exact palette, so the conversion can't lose anything.
+        QVector<QRgb> palette(colors.begin(), colors.end());
+        QByteArray indexed = EncodePng(argb.convertToFormat(QImage::Format_Indexed8, palette, Qt::ThresholdDither | Qt::AvoidDither));
+        if(indexed.size() < best.size()) {
+            best = indexed;
+        }
+    }
+    return best;
+}
+
+static bool WriteVariant(const QImage &img, const QString &outDir, const QString &path, QStringList &qrcFiles)
+{
+    QString outPath = outDir + "/" + path;
+    QDir().mkpath(QFileInfo(outPath).absolutePath());
+    QFile file(outPath);
+    if(!file.open(QIODevice::WriteOnly)) {
+        qCritical() << "Couldn't write" << outPath;
+        return false;
+    }
+    file.write(EncodeSmallest(img));
+    qrcFiles.append(path);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    if(args.size() < 4) {
+        qCritical() << "Usage: assetbaker <source dir> <output dir> <output qrc> <spec>...";
+        return 1;
+    }
+    QString srcDir = args[1];
+    QString outDir = args[2];
+    QString qrcPath = args[3];
+
+    QStringList qrcFiles;
+    for(int i = 4; i < args.size(); i++) {
+        QString path = args[i].section('=', 0, 0);
+        QString sizeSpec = args[i].section('=', 1, 1);
+
+        QImage src(srcDir + "/" + path);
+        if(src.isNull()) {
+            qCritical() << "Couldn't load" << path;
+            return 1;
+        }
+
+        if(sizeSpec.isEmpty()) {
+            if(!WriteVariant(src, outDir, path, qrcFiles)) {
+                return 1;
+            }
+            continue;
+        }
+
+        QSize box(sizeSpec.section('x', 0, 0).toInt(), sizeSpec.section('x', 1, 1).toInt());
+        if(box.isEmpty()) {
+            qCritical() << "Bad size for" << path << ":" << sizeSpec;
+            return 1;
+        }
+        // Never upscale; a smaller source just ships as-is.
+        QSize target = src.size().scaled(box, Qt::KeepAspectRatio).boundedTo(src.size());
+        QImage scaled = (target == src.size()) ? src : src.scaled(target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        if(!WriteVariant(scaled, outDir, path, qrcFiles)) {
+            return 1;
+        }
+
+        QSize target2x = target * 2;
+        if(src.width() >= target2x.width() && src.height() >= target2x.height()) {
+            QString path2x = path.left(path.lastIndexOf('.')) + "@2x" + path.mid(path.lastIndexOf('.'));
+            QImage scaled2x = (target2x == src.size()) ? src : src.scaled(target2x, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            if(!WriteVariant(scaled2x, outDir, path2x, qrcFiles)) {
+                return 1;
+            }
+        }
+    }
+
+    QFile qrc(qrcPath);
+    if(!qrc.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qCritical() << "Couldn't write" << qrcPath;
+        return 1;
+    }
+    QString qrcDir = QFileInfo(qrcPath).absolutePath();
+    QTextStream ts(&qrc);
+    ts << "<RCC>\n    <qresource prefix=\"/\">\n";
+    for(const QString &file : qrcFiles) {
+        QString absPath = QFileInfo(outDir + "/" + file).absoluteFilePath();
+        ts << "        <file alias=\"" << file << "\">" << QDir(qrcDir).relativeFilePath(absPath) << "</file>\n";
+    }
+    ts << "    </qresource>\n</RCC>\n";
+    return 0;
+}
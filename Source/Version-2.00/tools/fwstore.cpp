@@ -0,0 +1,62 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Maintenance tool for the local firmware store (see firmwarestore.h), e.g. to seed it
+// with every release in the repo's UF2/ folder.
+//
+// Usage: fwstore <store dir> add <name> <file.uf2>
+//        fwstore <store dir> extract <name> <file.uf2>
+//        fwstore <store dir> list
+
+#include "../firmwarestore.h"
+#include <QCoreApplication>
+#include <QTextStream>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    QTextStream err(stderr);
+    QTextStream out(stdout);
+    if(args.size() < 3) {
+        err << "Usage: " << args.value(0) << " <store dir> add|extract <name> <file.uf2> | list\n";
+        return 2;
+    }
+
+    FirmwareStore store;
+    if(!store.Open(args[1])) {
+        err << store.Error() << "\n";
+        return 1;
+    }
+    const QString command = args[2];
+    if(command == "list") {
+        for(const QString &name : store.Names()) {
+            out << store.Hash(name) << "  " << name << "\n";
+        }
+        return 0;
+    }
+    if(args.size() != 5 || (command != "add" && command != "extract")) {
+        err << "Usage: " << args[0] << " <store dir> add|extract <name> <file.uf2> | list\n";
+        return 2;
+    }
+    const bool ok = (command == "add") ? store.Add(args[3], args[4]) : store.Extract(args[3], args[4]);
+    if(!ok) {
+        err << store.Error() << "\n";
+        return 1;
+    }
+    return 0;
+}
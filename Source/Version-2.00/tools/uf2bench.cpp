@@ -0,0 +1,155 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Checks every UF2 under a folder (e.g. the repo's UF2/) through Uf2Map, prints what each
+// one covers, and times validating the lot: mapped in place, mapped and hashed, read into
+// memory the old way, and through each catalog.json found on the way.
+//
+// Usage: uf2bench <dir> [rounds]
+
+#include "../firmwarecatalog.h"
+#include "../uf2image.h"
+#include "../uf2map.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <functional>
+
+// Runs pass rounds times over bytes worth of images and prints its throughput; false if any pass failed.
+static bool Time(QTextStream &out, const QString &name, int rounds, qint64 bytes, const std::function<bool()> &pass)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for(int i = 0; i < rounds; i++) {
+        if(!pass()) {
+            out << name << ": failed\n";
+            return false;
+        }
+    }
+    const double seconds = qMax<qint64>(timer.nsecsElapsed(), 1) / 1e9;
+    out << QString("%1 %2 ms/round  %3 MB/s\n").arg(name, -22).arg(seconds * 1000 / rounds, 8, 'f', 3)
+           .arg(bytes * rounds / seconds / (1024 * 1024), 9, 'f', 1);
+    return true;
+}
+
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    QTextStream err(stderr);
+    QTextStream out(stdout);
+    if(args.size() < 2 || args.size() > 3) {
+        err << "Usage: " << args.value(0) << " <dir> [rounds]\n";
+        return 2;
+    }
+    const int rounds = qMax(args.value(2, "20").toInt(), 1);
+
+    QStringList files;
+    QStringList catalogs;
+    QDirIterator it(args[1], QDir::Files, QDirIterator::Subdirectories);
+    while(it.hasNext()) {
+        const QString path = it.next();
+        if(path.endsWith(".uf2", Qt::CaseInsensitive)) {
+            files.append(path);
+        } else if(QFileInfo(path).fileName() == FIRMWARE_CATALOG_FILE) {
+            catalogs.append(QFileInfo(path).path());
+        }
+    }
+    files.sort();
+    if(files.isEmpty()) {
+        err << "No .uf2 files under " << args[1] << "\n";
+        return 1;
+    }
+
+    int bad = 0;
+    qint64 bytes = 0;
+    for(const QString &path : files) {
+        Uf2Map map;
+        const bool ok = map.Open(path) && map.Validate();
+        const uf2Stats_s &stats = map.Stats();
+        bytes += map.Size();
+        QStringList families;
+        for(auto family = stats.families.constBegin(); family != stats.families.constEnd(); ++family) {
+            families.append(QString("%1x%2").arg(family.key(), 8, 16, QChar('0')).arg(family.value()));
+        }
+        out << QDir(args[1]).relativeFilePath(path) << ": " << stats.blocks << " blocks, "
+            << QString("0x%1-0x%2").arg(stats.addressLow, 8, 16, QChar('0')).arg(stats.addressHigh, 8, 16, QChar('0'))
+            << ", " << stats.coveredBytes / 1024 << " KB covered, " << stats.gaps << " gaps (" << stats.gapBytes << " bytes), "
+            << stats.duplicates << " duplicates, families " << families.join(' ') << "\n";
+        if(!ok) {
+            out << "    " << map.Error() << "\n";
+            bad++;
+        }
+    }
+    out << files.size() << " images, " << bytes / 1024 << " KB, " << bad << " bad\n\n";
+    if(bad) {
+        return 1;
+    }
+
+    bool ok = Time(out, "mapped", rounds, bytes, [&files]() {
+        for(const QString &path : files) {
+            Uf2Map map;
+            if(!map.Open(path) || !map.Validate()) {
+                return false;
+            }
+        }
+        return true;
+    });
+    ok &= Time(out, "mapped + sha256", rounds, bytes, [&files]() {
+        for(const QString &path : files) {
+            Uf2Map map;
+            if(!map.Open(path) || !map.Validate() || map.Hash().isEmpty()) {
+                return false;
+            }
+        }
+        return true;
+    });
+    ok &= Time(out, "read + parse", rounds, bytes, [&files]() {
+        for(const QString &path : files) {
+            QFile file(path);
+            Uf2Image image;
+            if(!file.open(QIODevice::ReadOnly) || !image.Parse(file.readAll())) {
+                return false;
+            }
+        }
+        return true;
+    });
+    for(const QString &dir : catalogs) {
+        FirmwareCatalog catalog;
+        catalog.LoadDir(dir);
+        const QList<firmwareEntry_s> entries = catalog.Entries();
+        qint64 listed = 0;
+        for(const firmwareEntry_s &entry : entries) {
+            listed += qMax<qint64>(entry.size, 0);
+        }
+        ok &= Time(out, "catalog " + QDir(args[1]).relativeFilePath(dir), rounds, listed, [&catalog, &entries, &err]() {
+            for(const firmwareEntry_s &entry : entries) {
+                if(!catalog.Verify(entry)) {
+                    err << catalog.Error() << "\n";
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+    return ok ? 0 : 1;
+}
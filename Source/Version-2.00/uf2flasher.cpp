@@ -0,0 +1,250 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "uf2flasher.h"
+#include "uf2map.h"
+#include <QDir>
+#include <QMap>
+#include <QTimer>
+#include <QtDebug>
+#ifdef Q_OS_WIN
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+Uf2Flasher::Uf2Flasher(QObject *parent)
+    : QObject(parent)
+{
+}
+
+
+bool Uf2Flasher::Start(const Uf2Image &image, const QString &mountPath, const QString &fileName)
+{
+    if(IsBusy()) {
+        error = "A flash is already in progress.";
+        return false;
+    }
+    if(image.Data().isEmpty()) {
+        error = "Nothing to flash.";
+        return false;
+    }
+    const QString boardId = BoardId(mountPath);
+    if(!boardId.startsWith(UF2_BOOTLOADER_BOARD_ID)) {
+        error = boardId.isEmpty() ? QString("%1 isn't a UF2 bootloader drive (it has no " UF2_INFO_FILE ").").arg(mountPath)
+                                  : QString("%1 is a %2 bootloader, not an RP2040's.").arg(mountPath, boardId);
+        return false;
+    }
+    this->mountPath = mountPath;
+    data = image.Data();
+    written = 0;
+    bodySize = data.size() - UF2_BLOCK_SIZE;
+    error.clear();
+    verification = uf2VerifyPassed;
+
+    // What the read-back should find: each page's payload, in address order (a later block for the same page wins, as on the chip).
+    // The final block's page isn't there yet when it's read.
+    Uf2Map map;
+    map.View(data);
+    const QMap<uint32_t, uint32_t> order = map.Pages();
+    const uint32_t lastBlock = map.BlockCount() - 1;
+    QCryptographicHash sha(QCryptographicHash::Sha256);
+    pages.clear();
+    for(auto it = order.constBegin(); it != order.constEnd(); ++it) {
+        if(it.value() == lastBlock) {
+            continue;
+        }
+        sha.addData(QByteArray::fromRawData(reinterpret_cast<const char*>(map.Block(it.value()).payload), UF2_PAYLOAD_SIZE));
+        pages.insert(it.key());
+    }
+    expected = sha.result();
+    addressHigh = image.AddressHigh();
+    target.setFileName(QDir(mountPath).filePath(fileName));
+    // Unbuffered, so each chunk goes to the OS as one write rather than being split up again.
+    if(!target.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        error = QString("Couldn't open %1 for writing: %2").arg(target.fileName(), target.errorString());
+        return false;
+    }
+    running = true;
+    timer.start();
+    emit Progress(0, data.size());
+    QTimer::singleShot(0, this, &Uf2Flasher::WriteNext);
+    return true;
+}
+
+
+// Pushes what's been written out of the OS's cache onto the device.
+static bool SyncFile(QFile &file)
+{
+#ifdef Q_OS_WIN
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(file.handle())));
+#else
+    return fsync(file.handle()) == 0;
+#endif
+}
+
+
+void Uf2Flasher::WriteNext()
+{
+    qint64 size = qMin<qint64>(UF2_WRITE_CHUNK, bodySize - written);
+    qint64 result = target.write(data.constData() + written, size);
+    if(result != size) {
+        Finish(false, QString("Writing to %1 failed after %2 of %3 bytes: %4")
+                      .arg(target.fileName()).arg(written + qMax<qint64>(result, 0)).arg(data.size()).arg(target.errorString()));
+        return;
+    }
+    written += size;
+    emit Progress(written, data.size());
+    if(written < bodySize) {
+        QTimer::singleShot(0, this, &Uf2Flasher::WriteNext);
+        return;
+    }
+
+    // Without the final block the bootloader is still waiting, so the drive has to stay put for this.
+    if(!SyncFile(target)) {
+        Finish(false, QString("Couldn't flush %1 to the device.").arg(target.fileName()));
+        return;
+    }
+    ReadBackStart();
+}
+
+
+void Uf2Flasher::WriteLast()
+{
+    qint64 result = target.write(data.constData() + bodySize, UF2_BLOCK_SIZE);
+    if(result != UF2_BLOCK_SIZE) {
+        Finish(false, QString("Writing the final block to %1 failed: %2").arg(target.fileName(), target.errorString()));
+        return;
+    }
+    written += UF2_BLOCK_SIZE;
+    emit Progress(written, data.size());
+    if(!SyncFile(target)) {
+        // The bootloader reboots as soon as it has the last block, which can take
+        // the drive away before the flush returns; that's a finished flash, not a failed one.
+        if(QDir(mountPath).exists()) {
+            Finish(false, QString("Couldn't flush %1 to the device.").arg(target.fileName()));
+            return;
+        }
+        qDebug() << "Bootloader drive went away during the final flush, as it does after the last block.";
+    }
+    Finish(true);
+}
+
+
+QString Uf2Flasher::BoardId(const QString &mountPath)
+{
+    QFile info(QDir(mountPath).filePath(UF2_INFO_FILE));
+    if(!info.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return QString();
+    }
+    while(!info.atEnd()) {
+        const QString line = QString::fromLatin1(info.readLine()).trimmed();
+        if(line.startsWith("Board-ID:")) {
+            return line.mid(9).trimmed();
+        }
+    }
+    return QString();
+}
+
+
+void Uf2Flasher::ReadBackStart()
+{
+    readSha.reset();
+    pagesRead = 0;
+    // A real drive shows the flash itself; a stand-in directory only has what we wrote.
+    QDir drive(mountPath);
+    source.setFileName(drive.exists(UF2_CURRENT_FILE) ? drive.filePath(UF2_CURRENT_FILE) : target.fileName());
+    if(!source.open(QIODevice::ReadOnly)) {
+        Finish(false, QString("Couldn't open %1 to read the flash back: %2").arg(source.fileName(), source.errorString()));
+        return;
+    }
+    emit Verifying();
+    QTimer::singleShot(0, this, &Uf2Flasher::ReadBackNext);
+}
+
+
+void Uf2Flasher::ReadBackNext()
+{
+    const QByteArray chunk = source.read(UF2_WRITE_CHUNK);
+    if(chunk.isEmpty()) {
+        if(source.atEnd()) {
+            ReadBackDone();
+        } else {
+            Finish(false, QString("Reading %1 back failed: %2").arg(source.fileName(), source.errorString()));
+        }
+        return;
+    }
+    if(chunk.size() % UF2_BLOCK_SIZE) {
+        Finish(false, QString("%1 read back as a partial block; it was cut short.").arg(source.fileName()));
+        return;
+    }
+
+    // Streamed rather than mapped: the drive is slow, and a page fault on it would stall the GUI.
+    Uf2Map map;
+    map.View(chunk);
+    for(uint32_t i = 0; i < map.BlockCount(); i++) {
+        const uf2BlockView_s block = map.Block(i);
+        if(!block.magicOk) {
+            Finish(false, QString("%1 has a damaged block at byte %2.").arg(source.fileName()).arg(source.pos() - chunk.size() + i * UF2_BLOCK_SIZE));
+            return;
+        }
+        if(block.flags & UF2_FLAG_NOT_MAIN_FLASH) {
+            continue;
+        }
+        const quint32 address = block.targetAddr;
+        if(pages.contains(address)) {
+            readSha.addData(QByteArray::fromRawData(reinterpret_cast<const char*>(block.payload), UF2_PAYLOAD_SIZE));
+            pagesRead++;
+        } else if(address >= addressHigh) {
+            // Pages come in address order, so the rest of the flash is past the image.
+            ReadBackDone();
+            return;
+        }
+    }
+    if(source.atEnd()) {
+        ReadBackDone();
+    } else {
+        QTimer::singleShot(0, this, &Uf2Flasher::ReadBackNext);
+    }
+}
+
+
+void Uf2Flasher::ReadBackDone()
+{
+    source.close();
+    if(pagesRead != pages.size() || readSha.result() != expected) {
+        Finish(false, QString("The flash read back from %1 doesn't match the image (%2 of %3 pages found); the write didn't land, flash it again.")
+                      .arg(source.fileName()).arg(pagesRead).arg(pages.size()));
+        return;
+    }
+    verification = pages.isEmpty() ? uf2VerifyUnverified : uf2VerifyPassed;
+    WriteLast();
+}
+
+
+void Uf2Flasher::Finish(bool ok, const QString &why)
+{
+    error = why;
+    running = false;
+    target.close();
+    source.close();
+    data.clear();
+    qint64 elapsed = timer.elapsed();
+    qDebug() << "UF2 flash" << (ok ? "finished" : "failed") << "in" << elapsed << "ms" << why;
+    emit Finished(ok, elapsed);
+}
@@ -0,0 +1,107 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef UF2FLASHER_H
+#define UF2FLASHER_H
+
+#include "uf2image.h"
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QObject>
+#include <QSet>
+
+// Bytes handed to the OS per write: whole blocks, and large enough that
+// the bootloader drive sees a few big requests instead of one per block.
+#define UF2_WRITE_CHUNK (64 * 1024)
+// Board id an RP2040 bootrom reports in INFO_UF2.TXT ("RPI-RP2" plus a revision)
+#define UF2_BOOTLOADER_BOARD_ID "RPI-RP2"
+// The bootrom's read-only view of the whole flash, as a UF2
+#define UF2_CURRENT_FILE "CURRENT.UF2"
+#define UF2_INFO_FILE "INFO_UF2.TXT"
+
+// How a finished flash was checked
+enum uf2Verify_e {
+    // Everything before the final block was read back from the drive and matched the image
+    uf2VerifyPassed = 0,
+    // The image is only its final block, so there was nothing to read back
+    uf2VerifyUnverified
+};
+
+// Copies a validated UF2 image onto an RP2040 bootloader drive, one chunk per
+// event loop pass so the GUI keeps running, and flushes it to the device.
+// The bootloader reboots as soon as it has every block, so the final block is held back:
+// the flash is read back through the drive's CURRENT.UF2 (or, on a plain directory standing
+// in for the drive, the file being written) and compared with the image first, and only then is it sent.
+class Uf2Flasher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Uf2Flasher(QObject *parent = nullptr);
+
+    // Starts writing image to mountPath/fileName. False if it couldn't start (see Error());
+    // otherwise Finished() is emitted once it's done either way.
+    bool Start(const Uf2Image &image, const QString &mountPath, const QString &fileName);
+
+    bool IsBusy() const { return running; }
+    const QString &Error() const { return error; }
+    // How the last successful flash was checked
+    uf2Verify_e Verification() const { return verification; }
+
+    // Board id from the drive's INFO_UF2.TXT, empty if it has none (i.e. it isn't a UF2 bootloader).
+    static QString BoardId(const QString &mountPath);
+
+signals:
+    void Progress(qint64 written, qint64 total);
+    // All but the final block is written; reading it back now.
+    void Verifying();
+    void Finished(bool ok, qint64 elapsedMs);
+
+private slots:
+    void WriteNext();
+    void ReadBackNext();
+
+private:
+    void ReadBackStart();
+    void ReadBackDone();
+    // Sends the held-back final block, which hands the image to the bootloader.
+    void WriteLast();
+    void Finish(bool ok, const QString &why = QString());
+
+    bool running = false;
+    QFile target;
+    QString mountPath;
+    QByteArray data;
+    qint64 written = 0;
+    // Bytes written before the read-back; the rest is the final block
+    qint64 bodySize = 0;
+    QElapsedTimer timer;
+    QString error;
+
+    // Read-back: where it comes from, the flash pages written before the final block, and the
+    // SHA-256 of those pages' payloads in address order, as expected and as read so far
+    QFile source;
+    QSet<uint32_t> pages;
+    uint32_t addressHigh = 0;
+    QByteArray expected;
+    QCryptographicHash readSha{QCryptographicHash::Sha256};
+    int pagesRead = 0;
+    uf2Verify_e verification = uf2VerifyPassed;
+};
+
+#endif // UF2FLASHER_H
@@ -0,0 +1,88 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "uf2image.h"
+#include "uf2map.h"
+#include <QtEndian>
+#include <cstring>
+
+bool Uf2Image::Fail(const QString &why)
+{
+    error = why;
+    data.clear();
+    return false;
+}
+
+
+bool Uf2Image::Load(const QString &path)
+{
+    Uf2Map map;
+    if(!map.Open(path)) {
+        return Fail(map.Error());
+    }
+    return Load(map);
+}
+
+
+bool Uf2Image::Load(Uf2Map &map)
+{
+    error.clear();
+    addressLow = 0;
+    addressHigh = 0;
+    if(!map.IsValid() && !map.Validate()) {
+        return Fail(map.Error());
+    }
+    // Checked in place, so this is the only copy made.
+    data = QByteArray(reinterpret_cast<const char*>(map.Bytes()), int(map.Size()));
+    addressLow = map.Stats().addressLow;
+    addressHigh = map.Stats().addressHigh;
+    return true;
+}
+
+
+uf2Block_s Uf2Image::Block(uint32_t i) const
+{
+    uf2Block_s block;
+    memcpy(&block, data.constData() + i * UF2_BLOCK_SIZE, sizeof(block));
+    block.magicStart0 = qFromLittleEndian(block.magicStart0);
+    block.magicStart1 = qFromLittleEndian(block.magicStart1);
+    block.flags = qFromLittleEndian(block.flags);
+    block.targetAddr = qFromLittleEndian(block.targetAddr);
+    block.payloadSize = qFromLittleEndian(block.payloadSize);
+    block.blockNo = qFromLittleEndian(block.blockNo);
+    block.numBlocks = qFromLittleEndian(block.numBlocks);
+    block.familyID = qFromLittleEndian(block.familyID);
+    block.magicEnd = qFromLittleEndian(block.magicEnd);
+    return block;
+}
+
+
+bool Uf2Image::Parse(const QByteArray &bytes)
+{
+    data = bytes;
+    error.clear();
+    addressLow = 0;
+    addressHigh = 0;
+    Uf2Map map;
+    map.View(data);
+    if(!map.Validate()) {
+        return Fail(map.Error());
+    }
+    addressLow = map.Stats().addressLow;
+    addressHigh = map.Stats().addressHigh;
+    return true;
+}
@@ -0,0 +1,90 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef UF2IMAGE_H
+#define UF2IMAGE_H
+
+#include <QByteArray>
+#include <QString>
+#include <cstdint>
+
+#define UF2_MAGIC_START0 0x0A324655
+#define UF2_MAGIC_START1 0x9E5D5157
+#define UF2_MAGIC_END 0x0AB16F30
+#define UF2_FLAG_NOT_MAIN_FLASH 0x00000001
+#define UF2_FLAG_FAMILY_ID 0x00002000
+#define UF2_BLOCK_SIZE 512
+// Payload bytes the RP2040 bootrom takes per block; it ignores anything else.
+#define UF2_PAYLOAD_SIZE 256
+
+#define RP2040_FAMILY_ID 0xE48BFF56
+#define RP2040_FLASH_START 0x10000000
+#define RP2040_FLASH_SIZE (16 * 1024 * 1024)
+
+// One 512-byte UF2 block, as laid out on disk (little endian).
+typedef struct uf2Block_t {
+    uint32_t magicStart0;
+    uint32_t magicStart1;
+    uint32_t flags;
+    uint32_t targetAddr;
+    uint32_t payloadSize;
+    uint32_t blockNo;
+    uint32_t numBlocks;
+    // Family id if UF2_FLAG_FAMILY_ID is set, otherwise file size/unused
+    uint32_t familyID;
+    uint8_t data[476];
+    uint32_t magicEnd;
+} uf2Block_s;
+
+static_assert(sizeof(uf2Block_s) == UF2_BLOCK_SIZE, "uf2Block_s must match the on-disk block");
+
+class Uf2Map;
+
+// A firmware image for the RP2040 bootloader, checked block by block before anything
+// gets near a gun: a file that fails here would otherwise only fail halfway through a flash.
+class Uf2Image
+{
+public:
+    // Reads and validates the file at path. On failure Error() says why.
+    bool Load(const QString &path);
+
+    // Takes a copy of an image mapped with Uf2Map, validating it first unless that's been done.
+    bool Load(Uf2Map &map);
+
+    // Validates an image already in memory.
+    bool Parse(const QByteArray &bytes);
+
+    const QByteArray &Data() const { return data; }
+    uint32_t BlockCount() const { return data.size() / UF2_BLOCK_SIZE; }
+    // Flash range the image covers
+    uint32_t AddressLow() const { return addressLow; }
+    uint32_t AddressHigh() const { return addressHigh; }
+    const QString &Error() const { return error; }
+
+    // Block i, byte-swapped to host order.
+    uf2Block_s Block(uint32_t i) const;
+
+private:
+    bool Fail(const QString &why);
+
+    QByteArray data;
+    uint32_t addressLow = 0;
+    uint32_t addressHigh = 0;
+    QString error;
+};
+
+#endif // UF2IMAGE_H
@@ -0,0 +1,191 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "uf2map.h"
+#include <QCryptographicHash>
+#include <QtEndian>
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+bool Uf2Map::Fail(const QString &why)
+{
+    if(error.isEmpty()) {
+        error = why;
+    }
+    valid = false;
+    return false;
+}
+
+
+bool Uf2Map::Open(const QString &path)
+{
+    Close();
+    file.setFileName(path);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return Fail(QString("Couldn't open %1: %2").arg(path, file.errorString()));
+    }
+    size = file.size();
+    if(size > 0) {
+        bytes = file.map(0, size);
+    }
+    if(!bytes) {
+        // Not every file can be mapped (empty ones, some network or removable drives); those just get read.
+        buffer = file.readAll();
+        if(buffer.size() != size) {
+            return Fail(QString("Couldn't read %1: %2").arg(path, file.errorString()));
+        }
+        bytes = reinterpret_cast<const uchar*>(buffer.constData());
+    }
+    return true;
+}
+
+
+void Uf2Map::View(const QByteArray &bytes)
+{
+    Close();
+    this->bytes = reinterpret_cast<const uchar*>(bytes.constData());
+    size = bytes.size();
+}
+
+
+void Uf2Map::Close()
+{
+    if(file.isOpen()) {
+        if(bytes && buffer.isEmpty()) {
+            file.unmap(const_cast<uchar*>(bytes));
+        }
+        file.close();
+    }
+    buffer.clear();
+    bytes = nullptr;
+    size = 0;
+    valid = false;
+    stats = uf2Stats_s();
+    error.clear();
+}
+
+
+uf2BlockView_s Uf2Map::Decode(const uchar *raw)
+{
+    uf2BlockView_s block;
+    block.magicOk = qFromLittleEndian<quint32>(raw + offsetof(uf2Block_s, magicStart0)) == UF2_MAGIC_START0 &&
+                    qFromLittleEndian<quint32>(raw + offsetof(uf2Block_s, magicStart1)) == UF2_MAGIC_START1 &&
+                    qFromLittleEndian<quint32>(raw + offsetof(uf2Block_s, magicEnd)) == UF2_MAGIC_END;
+    block.flags = qFromLittleEndian<quint32>(raw + offsetof(uf2Block_s, flags));
+    block.targetAddr = qFromLittleEndian<quint32>(raw + offsetof(uf2Block_s, targetAddr));
+    block.payloadSize = qFromLittleEndian<quint32>(raw + offsetof(uf2Block_s, payloadSize));
+    block.blockNo = qFromLittleEndian<quint32>(raw + offsetof(uf2Block_s, blockNo));
+    block.numBlocks = qFromLittleEndian<quint32>(raw + offsetof(uf2Block_s, numBlocks));
+    block.familyID = qFromLittleEndian<quint32>(raw + offsetof(uf2Block_s, familyID));
+    block.payload = raw + offsetof(uf2Block_s, data);
+    return block;
+}
+
+
+bool Uf2Map::Validate()
+{
+    valid = false;
+    stats = uf2Stats_s();
+    error.clear();
+    if(!bytes || size == 0 || size % UF2_BLOCK_SIZE) {
+        return Fail(QString("Not a UF2 file: %1 bytes isn't a whole number of %2-byte blocks.").arg(size).arg(UF2_BLOCK_SIZE));
+    }
+
+    const uint32_t count = BlockCount();
+    stats.blocks = count;
+    // Flash ranges written, as (address, length), for the coverage below
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    ranges.reserve(count);
+    for(uint32_t i = 0; i < count; i++) {
+        const uf2BlockView_s block = Block(i);
+        stats.families[(block.flags & UF2_FLAG_FAMILY_ID) ? block.familyID : 0]++;
+        if(!block.magicOk) {
+            Fail(QString("Block %1 has bad magic numbers; the file is corrupt or not a UF2.").arg(i));
+            continue;
+        }
+        if(block.blockNo != i || block.numBlocks != count) {
+            Fail(QString("Block %1 is numbered %2 of %3, but the file has %4 blocks; it's truncated or out of order.")
+                 .arg(i).arg(block.blockNo).arg(block.numBlocks).arg(count));
+        }
+        if(!(block.flags & UF2_FLAG_FAMILY_ID) || block.familyID != RP2040_FAMILY_ID) {
+            Fail(QString("Block %1 isn't marked for the RP2040 (family id %2).").arg(i).arg(block.familyID, 8, 16, QChar('0')));
+        }
+        if(block.flags & UF2_FLAG_NOT_MAIN_FLASH) {
+            continue;
+        }
+        stats.flashBlocks++;
+        if(block.payloadSize != UF2_PAYLOAD_SIZE || block.targetAddr % UF2_PAYLOAD_SIZE) {
+            Fail(QString("Block %1 carries %2 bytes at 0x%3; the RP2040 bootloader only takes aligned 256-byte pages.")
+                 .arg(i).arg(block.payloadSize).arg(block.targetAddr, 8, 16, QChar('0')));
+        }
+        // Compared without adding to targetAddr, which would wrap for blocks near the top of the address space.
+        if(block.targetAddr < RP2040_FLASH_START || block.targetAddr > RP2040_FLASH_START + RP2040_FLASH_SIZE - UF2_PAYLOAD_SIZE) {
+            Fail(QString("Block %1 targets 0x%2, outside the RP2040's flash.").arg(i).arg(block.targetAddr, 8, 16, QChar('0')));
+        }
+        if(block.payloadSize <= sizeof(uf2Block_s::data)) {
+            ranges.emplace_back(block.targetAddr, block.payloadSize);
+        }
+    }
+
+    // Shipped images are already in address order, so this sort is mostly a pass over them.
+    std::sort(ranges.begin(), ranges.end());
+    uint64_t end = 0;
+    for(size_t i = 0; i < ranges.size(); i++) {
+        const uint64_t low = ranges[i].first;
+        const uint64_t high = low + ranges[i].second;
+        if(i == 0) {
+            stats.addressLow = ranges[i].first;
+        } else if(low == ranges[i - 1].first) {
+            stats.duplicates++;
+        } else if(low > end) {
+            stats.gaps++;
+            stats.gapBytes += low - end;
+        }
+        if(high > end) {
+            stats.coveredBytes += high - qMax(low, end);
+            end = high;
+        }
+    }
+    stats.addressHigh = uint32_t(qMin<uint64_t>(end, UINT32_MAX));
+
+    if(error.isEmpty() && stats.coveredBytes == 0) {
+        Fail("The file doesn't write anything to flash.");
+    }
+    valid = error.isEmpty();
+    return valid;
+}
+
+
+QMap<uint32_t, uint32_t> Uf2Map::Pages() const
+{
+    QMap<uint32_t, uint32_t> pages;
+    for(uint32_t i = 0; i < BlockCount(); i++) {
+        const uf2BlockView_s block = Block(i);
+        if(!(block.flags & UF2_FLAG_NOT_MAIN_FLASH)) {
+            pages.insert(block.targetAddr, i);
+        }
+    }
+    return pages;
+}
+
+
+QByteArray Uf2Map::Hash() const
+{
+    return QCryptographicHash::hash(QByteArray::fromRawData(reinterpret_cast<const char*>(bytes), int(size)), QCryptographicHash::Sha256);
+}
@@ -0,0 +1,112 @@
+/*  P.I.G.S-GUI: a configuration utility for the P.I.G.S light gun system.
+    Copyright (C) 2024  That One Seong
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef UF2MAP_H
+#define UF2MAP_H
+
+#include "uf2image.h"
+#include <QByteArray>
+#include <QFile>
+#include <QMap>
+#include <QString>
+#include <cstdint>
+
+// One block of a mapped image: its header in host order, and its payload where it lies in the file.
+typedef struct uf2BlockView_t {
+    bool magicOk;
+    uint32_t flags;
+    uint32_t targetAddr;
+    uint32_t payloadSize;
+    uint32_t blockNo;
+    uint32_t numBlocks;
+    uint32_t familyID;
+    const uchar *payload;
+} uf2BlockView_s;
+
+// What Validate() found over the whole image.
+typedef struct uf2Stats_t {
+    uint32_t blocks = 0;
+    // Blocks meant for main flash, i.e. without UF2_FLAG_NOT_MAIN_FLASH
+    uint32_t flashBlocks = 0;
+    // Flash range written, and how much of it actually is
+    uint32_t addressLow = 0;
+    uint32_t addressHigh = 0;
+    uint32_t coveredBytes = 0;
+    // Unwritten holes inside that range
+    uint32_t gaps = 0;
+    uint32_t gapBytes = 0;
+    // Blocks writing an address an earlier block already wrote
+    uint32_t duplicates = 0;
+    // Family id (0 for blocks that don't carry one) -> blocks
+    QMap<uint32_t, uint32_t> families;
+} uf2Stats_s;
+
+// A UF2 file mapped into memory and walked in place: blocks are read where they lie,
+// so checking an image costs page-cache reads rather than a copy of it.
+// Uf2Image (and so the flasher and the catalog) reads files through this.
+class Uf2Map
+{
+public:
+    Uf2Map() = default;
+    Uf2Map(const Uf2Map &) = delete;
+    Uf2Map &operator=(const Uf2Map &) = delete;
+    ~Uf2Map() { Close(); }
+
+    // Maps the file at path, or reads it in if it can't be mapped. On failure Error() says why.
+    bool Open(const QString &path);
+
+    // Walks bytes in place; they must outlive the map (or the next Open/View/Close).
+    void View(const QByteArray &bytes);
+
+    void Close();
+
+    const uchar *Bytes() const { return bytes; }
+    qint64 Size() const { return size; }
+    uint32_t BlockCount() const { return size / UF2_BLOCK_SIZE; }
+
+    // Block at raw, which must have UF2_BLOCK_SIZE bytes.
+    static uf2BlockView_s Decode(const uchar *raw);
+    uf2BlockView_s Block(uint32_t i) const { return Decode(bytes + qint64(i) * UF2_BLOCK_SIZE); }
+
+    // Checks every block is one the RP2040 bootloader takes, filling in Stats() as it goes;
+    // the stats cover the whole file even when it fails, Error() names the first bad block.
+    bool Validate();
+    bool IsValid() const { return valid; }
+    const uf2Stats_s &Stats() const { return stats; }
+
+    // Main flash pages by address, each to the block that writes it last (which is what ends up on the chip).
+    QMap<uint32_t, uint32_t> Pages() const;
+
+    // SHA-256 of the whole file.
+    QByteArray Hash() const;
+
+    const QString &Error() const { return error; }
+
+private:
+    bool Fail(const QString &why);
+
+    QFile file;
+    // Only used when the file couldn't be mapped
+    QByteArray buffer;
+    const uchar *bytes = nullptr;
+    qint64 size = 0;
+    bool valid = false;
+    uf2Stats_s stats;
+    QString error;
+};
+
+#endif // UF2MAP_H